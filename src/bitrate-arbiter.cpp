@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bitrate-arbiter.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <random>
+
+namespace {
+uint64_t randomToken() noexcept {
+    std::random_device device;
+    uint64_t token{(static_cast<uint64_t>(device()) << 32) ^ device() ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())};
+    return (0 == token) ? 1 : token;
+}
+}
+
+BitrateArbiter::BitrateArbiter(const std::string &group, uint32_t id, float priority, uint32_t budget, uint32_t minimumBitrate, uint32_t maximumBitrate) noexcept
+    : m_name{"/opendlv-video-h264-bitrate-" + group}
+    , m_id{id}
+    , m_priority{std::max(priority, 0.0f)}
+    , m_budget{budget}
+    , m_minimumBitrate{minimumBitrate}
+    , m_maximumBitrate{std::max(minimumBitrate, maximumBitrate)}
+    , m_token{randomToken()} {
+    // The area outlives its creator so that the remaining encoders keep their slots.
+    const int fd{::shm_open(m_name.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH)};
+    if (-1 == fd) {
+        return;
+    }
+    const std::size_t SIZE{sizeof(BitrateTableSlot) * BitrateTableSlot::NUMBER_OF_SLOTS};
+    struct stat info{};
+    // A new area is zero-filled by ftruncate, which marks all slots as free.
+    if ( (0 == ::fstat(fd, &info)) && ((static_cast<std::size_t>(info.st_size) >= SIZE) || (0 == ::ftruncate(fd, SIZE))) ) {
+        void *table{::mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+        m_table = (MAP_FAILED == table) ? nullptr : static_cast<BitrateTableSlot*>(table);
+    }
+    ::close(fd);
+    if (nullptr == m_table) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lck(m_slotMutex);
+    if (claim(now())) {
+        m_running = true;
+        m_heartbeatThread = std::thread(&BitrateArbiter::refreshHeartbeat, this);
+    }
+}
+
+BitrateArbiter::~BitrateArbiter() noexcept {
+    {
+        std::lock_guard<std::mutex> lck(m_slotMutex);
+        m_running = false;
+    }
+    m_slotCondition.notify_all();
+    if (m_heartbeatThread.joinable()) {
+        m_heartbeatThread.join();
+    }
+    if ( (nullptr != m_slot) && (m_token == m_slot->owner.load()) ) {
+        m_slot->weight.store(0);
+        uint64_t owner{m_token};
+        m_slot->owner.compare_exchange_strong(owner, 0);
+    }
+    if (nullptr != m_table) {
+        ::munmap(m_table, sizeof(BitrateTableSlot) * BitrateTableSlot::NUMBER_OF_SLOTS);
+    }
+}
+
+bool BitrateArbiter::valid() const noexcept {
+    std::lock_guard<std::mutex> lck(m_slotMutex);
+    return (nullptr != m_slot);
+}
+
+const std::string &BitrateArbiter::name() const noexcept {
+    return m_name;
+}
+
+uint32_t BitrateArbiter::update(double complexity) noexcept {
+    std::lock_guard<std::mutex> lck(m_slotMutex);
+    const int64_t NOW{now()};
+    if (!claim(NOW)) {
+        return m_maximumBitrate;
+    }
+    // At least a weight of 1 so that a static scene still gets its share when all scenes are static.
+    const uint64_t WEIGHT{std::max(static_cast<uint64_t>(m_priority * std::max(complexity, 0.0)), static_cast<uint64_t>(1))};
+    m_slot->weight.store(WEIGHT);
+    m_slot->heartbeat.store(NOW);
+
+    uint64_t sumOfWeights{0};
+    for (uint32_t i{0}; i < BitrateTableSlot::NUMBER_OF_SLOTS; i++) {
+        const BitrateTableSlot &s = m_table[i];
+        if ( (0 != s.owner.load()) && (NOW - s.heartbeat.load() <= BitrateTableSlot::TIMEOUT_MS) ) {
+            sumOfWeights += s.weight.load();
+        }
+    }
+
+    const double SHARE{static_cast<double>(WEIGHT) / static_cast<double>(std::max(sumOfWeights, WEIGHT))};
+    const uint32_t BITRATE{std::min(std::max(static_cast<uint32_t>(SHARE * m_budget), m_minimumBitrate), m_maximumBitrate)};
+    m_slot->bitrate.store(BITRATE);
+    return BITRATE;
+}
+
+double BitrateArbiter::complexity(double bitsPerSecond, uint32_t averageQP) noexcept {
+    constexpr double REFERENCE_QP{26.0};
+    return (0 == averageQP) ? bitsPerSecond : bitsPerSecond * std::pow(2.0, (static_cast<double>(averageQP) - REFERENCE_QP) / 6.0);
+}
+
+bool BitrateArbiter::claim(int64_t now) noexcept {
+    if ( (nullptr != m_slot) && (m_token == m_slot->owner.load()) ) {
+        return true;
+    }
+    // The slot was lost, for instance after the heartbeat could not be
+    // refreshed in time; the encoder that took it over keeps it.
+    m_slot = nullptr;
+    for (uint32_t i{0}; (nullptr != m_table) && (i < BitrateTableSlot::NUMBER_OF_SLOTS); i++) {
+        BitrateTableSlot &s = m_table[i];
+        uint64_t owner{s.owner.load()};
+        const bool STALE{(0 != owner) && (now - s.heartbeat.load() > BitrateTableSlot::TIMEOUT_MS)};
+        if ( ((0 == owner) || STALE) && s.owner.compare_exchange_strong(owner, m_token) ) {
+            s.heartbeat.store(now);
+            s.id.store(m_id);
+            s.weight.store(0);
+            s.bitrate.store(0);
+            // Another encoder may have considered the stale heartbeat before it was refreshed.
+            if (m_token == s.owner.load()) {
+                m_slot = &s;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void BitrateArbiter::refreshHeartbeat() noexcept {
+    std::unique_lock<std::mutex> lck(m_slotMutex);
+    while (m_running) {
+        m_slotCondition.wait_for(lck, std::chrono::milliseconds(BitrateTableSlot::TIMEOUT_MS / 4));
+        if (m_running) {
+            const int64_t NOW{now()};
+            if (claim(NOW)) {
+                m_slot->heartbeat.store(NOW);
+            }
+        }
+    }
+}
+
+int64_t BitrateArbiter::now() noexcept {
+    struct timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
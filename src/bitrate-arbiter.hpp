@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BITRATE_ARBITER_HPP
+#define BITRATE_ARBITER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Layout of the shared memory area used by BitrateArbiter: an array of
+ * BitrateTableSlot::NUMBER_OF_SLOTS slots, one per encoder of a group. A slot
+ * is free when owner is 0 or when its heartbeat is older than
+ * BitrateTableSlot::TIMEOUT_MS milliseconds; all fields are updated lock-free.
+ * The owner is a random token and not a process ID as encoders in different
+ * containers share the table but not their PID namespaces.
+ */
+struct BitrateTableSlot {
+    static constexpr uint32_t NUMBER_OF_SLOTS{32};
+    static constexpr int64_t TIMEOUT_MS{2000};
+
+    std::atomic<uint64_t> owner;     // Token of the owning encoder; 0: free.
+    std::atomic<uint32_t> id;        // --id of the owning encoder.
+    std::atomic<uint64_t> weight;    // priority * complexity.
+    std::atomic<uint32_t> bitrate;   // Bitrate currently assigned.
+    std::atomic<int64_t> heartbeat;  // CLOCK_MONOTONIC in milliseconds.
+};
+
+/**
+ * This class splits a total bitrate budget among all encoders of a group,
+ * which may run in different processes on the same host. Every encoder
+ * periodically publishes its weight (priority times scene complexity) into a
+ * small shared memory table and takes the share of the budget that
+ * corresponds to its weight; as all encoders apply the same rule to the same
+ * table, no separate coordinator is needed.
+ *
+ * A separate thread refreshes the heartbeat so that an encoder keeps its slot
+ * while its producer pauses; a slot that was taken over nevertheless is
+ * replaced by a free one.
+ */
+class BitrateArbiter {
+   private:
+    BitrateArbiter(const BitrateArbiter &) = delete;
+    BitrateArbiter(BitrateArbiter &&)      = delete;
+    BitrateArbiter &operator=(const BitrateArbiter &) = delete;
+    BitrateArbiter &operator=(BitrateArbiter &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param group Name of the group sharing one budget.
+     * @param id Identifier of this encoder.
+     * @param priority Priority of this encoder relative to the others.
+     * @param budget Total bitrate of all encoders of the group.
+     * @param minimumBitrate Lower limit for this encoder's bitrate.
+     * @param maximumBitrate Upper limit for this encoder's bitrate.
+     */
+    BitrateArbiter(const std::string &group, uint32_t id, float priority, uint32_t budget, uint32_t minimumBitrate, uint32_t maximumBitrate) noexcept;
+    ~BitrateArbiter() noexcept;
+
+   public:
+    /**
+     * @return true if a slot in the group's table was claimed.
+     */
+    bool valid() const noexcept;
+
+    /**
+     * @return Name of the shared memory area holding the table.
+     */
+    const std::string &name() const noexcept;
+
+    /**
+     * This method publishes this encoder's scene complexity and computes its share.
+     *
+     * @param complexity Scene complexity, e.g., bitrate normalized to a reference QP.
+     * @return Bitrate assigned to this encoder.
+     */
+    uint32_t update(double complexity) noexcept;
+
+    /**
+     * @param bitsPerSecond Bitrate produced by the encoder.
+     * @param averageQP Average quantization parameter (0: unknown).
+     * @return Bitrate that would have been needed at QP 26, as the bitrate roughly halves per +6 QP.
+     */
+    static double complexity(double bitsPerSecond, uint32_t averageQP) noexcept;
+
+   private:
+    static int64_t now() noexcept;
+    bool claim(int64_t now) noexcept;
+    void refreshHeartbeat() noexcept;
+
+   private:
+    const std::string m_name;
+    const uint32_t m_id;
+    const float m_priority;
+    const uint32_t m_budget;
+    const uint32_t m_minimumBitrate;
+    const uint32_t m_maximumBitrate;
+
+    const uint64_t m_token;
+
+    BitrateTableSlot *m_table{nullptr};
+
+    mutable std::mutex m_slotMutex{};
+    std::condition_variable m_slotCondition{};
+    BitrateTableSlot *m_slot{nullptr};
+    bool m_running{false};
+    std::thread m_heartbeatThread{};
+};
+
+#endif
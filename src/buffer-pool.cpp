@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "buffer-pool.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+BufferPool::BufferPool(std::size_t bufferSize, uint32_t numberOfBuffers, bool useHugePages) noexcept {
+    constexpr std::size_t HUGE_PAGE_SIZE{2 * 1024 * 1024};
+    const std::size_t PAGE_SIZE{static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))};
+
+    // Page-aligned buffers are suitable for SIMD access and O_DIRECT I/O.
+    m_bufferSize = ((std::max<std::size_t>(bufferSize, 1) + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+    m_length = m_bufferSize * numberOfBuffers;
+    if (0 == m_length) {
+        return;
+    }
+
+    void *memory{MAP_FAILED};
+    if (useHugePages) {
+        const std::size_t LENGTH{((m_length + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE};
+        memory = ::mmap(nullptr, LENGTH, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (MAP_FAILED != memory) {
+            m_length = LENGTH;
+            m_usesHugePages = true;
+        }
+    }
+    if (MAP_FAILED == memory) {
+        // Not populated here: the pages are faulted in below, after asking for
+        // transparent huge pages, which would not replace already faulted ones.
+        memory = ::mmap(nullptr, m_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ( (MAP_FAILED != memory) && useHugePages) {
+            // No reserved huge pages available; ask for transparent ones instead.
+            ::madvise(memory, m_length, MADV_HUGEPAGE);
+        }
+    }
+    if (MAP_FAILED == memory) {
+        m_length = 0;
+        return;
+    }
+    m_memory = static_cast<uint8_t*>(memory);
+
+    // Write to every page so that it is backed by physical memory local to
+    // the calling thread's NUMA node before the first frame arrives; keep it
+    // resident if permitted.
+    std::memset(m_memory, 0, m_length);
+    ::mlock(m_memory, m_length);
+
+    m_freeBuffers.reserve(numberOfBuffers);
+    for (uint32_t i{numberOfBuffers}; i > 0; i--) {
+        m_freeBuffers.push_back(m_memory + (i - 1) * m_bufferSize);
+    }
+}
+
+BufferPool::~BufferPool() noexcept {
+    if (nullptr != m_memory) {
+        ::munmap(m_memory, m_length);
+    }
+}
+
+bool BufferPool::valid() const noexcept {
+    return (nullptr != m_memory);
+}
+
+bool BufferPool::usesHugePages() const noexcept {
+    return m_usesHugePages;
+}
+
+std::size_t BufferPool::bufferSize() const noexcept {
+    return m_bufferSize;
+}
+
+uint8_t *BufferPool::acquire() noexcept {
+    std::lock_guard<std::mutex> lck(m_freeBuffersMutex);
+    uint8_t *buffer{nullptr};
+    if (!m_freeBuffers.empty()) {
+        buffer = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    }
+    return buffer;
+}
+
+void BufferPool::release(uint8_t *buffer) noexcept {
+    if ( (nullptr != buffer) && (buffer >= m_memory) && (buffer < m_memory + m_length) ) {
+        std::lock_guard<std::mutex> lck(m_freeBuffersMutex);
+        // Capacity was reserved for all buffers, hence this never allocates.
+        m_freeBuffers.push_back(buffer);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * This class provides a fixed number of equally sized, page-aligned buffers
+ * carved out of one anonymous memory mapping. All pages are pre-faulted when
+ * the pool is created so that acquiring and using a buffer in the frame loop
+ * neither allocates from the heap nor triggers page faults. Optionally, the
+ * mapping is backed by 2 MB huge pages to reduce TLB pressure for large frames.
+ */
+class BufferPool {
+   private:
+    BufferPool(const BufferPool &) = delete;
+    BufferPool(BufferPool &&)      = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+    BufferPool &operator=(BufferPool &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param bufferSize Minimum size in bytes of each buffer.
+     * @param numberOfBuffers Number of buffers in the pool.
+     * @param useHugePages Try to back the pool with 2 MB huge pages; falls back
+     *        to transparent huge pages or regular pages when unavailable.
+     */
+    BufferPool(std::size_t bufferSize, uint32_t numberOfBuffers, bool useHugePages = false) noexcept;
+    ~BufferPool() noexcept;
+
+   public:
+    /**
+     * @return true if the memory for the pool could be mapped.
+     */
+    bool valid() const noexcept;
+
+    /**
+     * @return true if the pool is backed by explicit huge pages.
+     */
+    bool usesHugePages() const noexcept;
+
+    /**
+     * @return Usable size of each buffer (multiple of the page size).
+     */
+    std::size_t bufferSize() const noexcept;
+
+    /**
+     * @return Free buffer or nullptr when all buffers are in use.
+     */
+    uint8_t *acquire() noexcept;
+
+    /**
+     * This method returns a buffer obtained from acquire() to the pool.
+     *
+     * @param buffer Buffer to return.
+     */
+    void release(uint8_t *buffer) noexcept;
+
+   private:
+    uint8_t *m_memory{nullptr};
+    std::size_t m_length{0};
+    std::size_t m_bufferSize{0};
+    bool m_usesHugePages{false};
+
+    std::mutex m_freeBuffersMutex{};
+    std::vector<uint8_t *> m_freeBuffers{};
+};
+
+#endif
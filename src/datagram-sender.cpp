@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "datagram-sender.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#if defined(__linux__) && !defined(UDP_SEGMENT)
+    // Available since Linux 4.18; older C libraries lack the definition.
+    #define UDP_SEGMENT 103
+#endif
+
+namespace {
+// Limits of the kernel for one UDP_SEGMENT send.
+constexpr uint32_t MAXIMUM_SEGMENTS{64};
+constexpr std::size_t MAXIMUM_SEGMENTED_LENGTH{65507};
+}
+
+DatagramSender::DatagramSender(const std::string &address, uint16_t port, std::size_t maximumDatagramSize, uint32_t maximumBatchSize) noexcept
+    : m_maximumDatagramSize{std::max<std::size_t>(maximumDatagramSize, 1)}
+    , m_maximumBatchSize{std::max(maximumBatchSize, 1u)} {
+    struct sockaddr_in sendToAddress;
+    std::memset(&sendToAddress, 0, sizeof(sendToAddress));
+    sendToAddress.sin_family = AF_INET;
+    sendToAddress.sin_port = htons(port);
+    if ( (0 == port) || (1 != ::inet_pton(AF_INET, address.c_str(), &sendToAddress.sin_addr)) ) {
+        std::cerr << "[DatagramSender]: Invalid address " << address << ":" << port << "." << std::endl;
+        return;
+    }
+    m_socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (0 > m_socket) {
+        std::cerr << "[DatagramSender]: Failed to create socket: " << strerror(errno) << std::endl;
+        return;
+    }
+    // Connecting saves looking up the route for every datagram.
+    if (0 != ::connect(m_socket, reinterpret_cast<struct sockaddr*>(&sendToAddress), sizeof(sendToAddress))) {
+        std::cerr << "[DatagramSender]: Failed to connect to " << address << ":" << port << ": " << strerror(errno) << std::endl;
+        ::close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    m_batch.resize(m_maximumBatchSize * m_maximumDatagramSize);
+    m_lengths.reserve(m_maximumBatchSize);
+    m_messages.resize(m_maximumBatchSize);
+    m_iovecs.resize(m_maximumBatchSize);
+    m_datagramsPerMessage.resize(m_maximumBatchSize);
+    m_controls.resize(m_maximumBatchSize * CMSG_SPACE(sizeof(uint16_t)));
+#ifdef UDP_SEGMENT
+    // Kernels that know the option accept reading it.
+    int32_t segmentSize{0};
+    socklen_t length{sizeof(segmentSize)};
+    m_useSegmentationOffload.store(0 == ::getsockopt(m_socket, SOL_UDP, UDP_SEGMENT, &segmentSize, &length));
+#endif
+}
+
+DatagramSender::~DatagramSender() noexcept {
+    if (-1 != m_socket) {
+        ::close(m_socket);
+    }
+}
+
+bool DatagramSender::valid() const noexcept {
+    return -1 != m_socket;
+}
+
+bool DatagramSender::setMaximumPacingRate(uint64_t bitsPerSecond) noexcept {
+#ifdef SO_MAX_PACING_RATE
+    // The option is given in bytes per second; 32-bit kernels only accept 32-bit values.
+    const uint64_t BYTES_PER_SECOND{bitsPerSecond / 8};
+    const uint32_t RATE{static_cast<uint32_t>(std::min<uint64_t>(BYTES_PER_SECOND, std::numeric_limits<uint32_t>::max()))};
+    return valid() && (0 == ::setsockopt(m_socket, SOL_SOCKET, SO_MAX_PACING_RATE, &RATE, sizeof(RATE)));
+#else
+    (void)bitsPerSecond;
+    return false;
+#endif
+}
+
+std::pair<ssize_t, int32_t> DatagramSender::send(const uint8_t *data, std::size_t length) noexcept {
+    if (!valid()) {
+        return std::make_pair(-1, EBADF);
+    }
+    ssize_t sent{-1};
+    do {
+        sent = ::send(m_socket, data, length, 0);
+        m_systemCalls++;
+    } while ( (0 > sent) && (EINTR == errno) );
+    if (0 > sent) {
+        m_failedDatagrams++;
+        return std::make_pair(sent, errno);
+    }
+    m_datagrams++;
+    m_bytes += static_cast<uint64_t>(sent);
+    return std::make_pair(sent, 0);
+}
+
+bool DatagramSender::append(const uint8_t *data, std::size_t length) noexcept {
+    if (!valid() || (m_maximumDatagramSize < length)) {
+        m_failedDatagrams++;
+        return false;
+    }
+    if (m_maximumBatchSize == m_lengths.size()) {
+        flush();
+    }
+    memcpy(m_batch.data() + m_batchLength, data, length);
+    m_lengths.push_back(static_cast<uint32_t>(length));
+    m_batchLength += length;
+    return true;
+}
+
+uint32_t DatagramSender::flush() noexcept {
+    uint32_t sent{0};
+    std::size_t first{0};
+    std::size_t offset{0};
+    // Only this thread clears the flag; hence, a local copy stays accurate.
+    bool useSegmentationOffload{m_useSegmentationOffload.load()};
+    while (first < m_lengths.size()) {
+        // Prepare one message per datagram or per run of datagrams to segment.
+        uint32_t numberOfMessages{0};
+        for (std::size_t i{first}, o{offset}; i < m_lengths.size(); numberOfMessages++) {
+            uint32_t count{1};
+            std::size_t length{m_lengths[i]};
+            if (useSegmentationOffload) {
+                // All datagrams of a run have the same size; only the last one may be shorter.
+                while ( (i + count < m_lengths.size()) && (count < MAXIMUM_SEGMENTS)
+                     && (m_lengths[i + count - 1] == m_lengths[i]) && (m_lengths[i + count] <= m_lengths[i])
+                     && (length + m_lengths[i + count] <= MAXIMUM_SEGMENTED_LENGTH) ) {
+                    length += m_lengths[i + count];
+                    count++;
+                }
+            }
+            m_iovecs[numberOfMessages].iov_base = m_batch.data() + o;
+            m_iovecs[numberOfMessages].iov_len = length;
+            struct msghdr &message = m_messages[numberOfMessages].msg_hdr;
+            std::memset(&m_messages[numberOfMessages], 0, sizeof(struct mmsghdr));
+            message.msg_iov = &m_iovecs[numberOfMessages];
+            message.msg_iovlen = 1;
+#ifdef UDP_SEGMENT
+            if (1 < count) {
+                message.msg_control = m_controls.data() + numberOfMessages * CMSG_SPACE(sizeof(uint16_t));
+                message.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                struct cmsghdr *control = CMSG_FIRSTHDR(&message);
+                control->cmsg_level = SOL_UDP;
+                control->cmsg_type = UDP_SEGMENT;
+                control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                const uint16_t SEGMENT_SIZE{static_cast<uint16_t>(m_lengths[i])};
+                memcpy(CMSG_DATA(control), &SEGMENT_SIZE, sizeof(SEGMENT_SIZE));
+            }
+#endif
+            m_datagramsPerMessage[numberOfMessages] = count;
+            i += count;
+            o += length;
+        }
+
+        int32_t result{-1};
+        do {
+            result = ::sendmmsg(m_socket, m_messages.data(), numberOfMessages, 0);
+            m_systemCalls++;
+        } while ( (0 > result) && (EINTR == errno) );
+
+        if (0 < result) {
+            for (int32_t message{0}; message < result; message++) {
+                sent += m_datagramsPerMessage[message];
+                first += m_datagramsPerMessage[message];
+                offset += m_iovecs[message].iov_len;
+                m_bytes += m_iovecs[message].iov_len;
+            }
+            continue;
+        }
+        if ( useSegmentationOffload && (1 < m_datagramsPerMessage[0]) && ( (EIO == errno) || (EINVAL == errno) ) ) {
+            // The network card cannot compute checksums for segmentation or a datagram exceeds the device's MTU.
+            std::cerr << "[DatagramSender]: UDP segmentation offload failed (" << strerror(errno) << "); sending datagrams individually." << std::endl;
+            useSegmentationOffload = false;
+            m_useSegmentationOffload.store(false);
+            continue;
+        }
+        // Skip the failing message.
+        m_failedDatagrams += m_datagramsPerMessage[0];
+        first += m_datagramsPerMessage[0];
+        offset += m_iovecs[0].iov_len;
+    }
+    m_datagrams += sent;
+    m_lengths.clear();
+    m_batchLength = 0;
+    return sent;
+}
+
+uint32_t DatagramSender::maximumBatchSize() const noexcept {
+    return m_maximumBatchSize;
+}
+
+bool DatagramSender::usesSegmentationOffload() const noexcept {
+    return m_useSegmentationOffload.load();
+}
+
+DatagramSender::Statistics DatagramSender::statistics() noexcept {
+    Statistics statistics;
+    statistics.m_datagrams = m_datagrams.exchange(0);
+    statistics.m_bytes = m_bytes.exchange(0);
+    statistics.m_systemCalls = m_systemCalls.exchange(0);
+    statistics.m_failedDatagrams = m_failedDatagrams.exchange(0);
+    return statistics;
+}
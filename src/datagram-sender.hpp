@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATAGRAM_SENDER_HPP
+#define DATAGRAM_SENDER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * This class sends UDP datagrams to one IPv4 unicast or multicast address.
+ * Unlike cluon::UDPSender, it exposes the socket options needed for sending
+ * media streams, such as the kernel's pacing rate.
+ *
+ * Datagrams can be collected into a batch that is sent with a single
+ * sendmmsg call, e.g., all RTP packets of one access unit. Where the kernel
+ * supports UDP generic segmentation offload (UDP_SEGMENT), consecutive
+ * datagrams of equal size are passed as one large buffer that the kernel or
+ * the network card splits into datagrams, saving the per-datagram traversal
+ * of the network stack.
+ */
+class DatagramSender {
+   private:
+    DatagramSender(const DatagramSender &) = delete;
+    DatagramSender(DatagramSender &&)      = delete;
+    DatagramSender &operator=(const DatagramSender &) = delete;
+    DatagramSender &operator=(DatagramSender &&) = delete;
+
+   public:
+    class Statistics {
+       public:
+        uint64_t m_datagrams{0};
+        uint64_t m_bytes{0};
+        uint64_t m_systemCalls{0};
+        uint64_t m_failedDatagrams{0};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param address Numerical IPv4 address to send to.
+     * @param port Port to send to.
+     * @param maximumDatagramSize Maximum size of a datagram in a batch.
+     * @param maximumBatchSize Maximum number of datagrams in a batch.
+     */
+    DatagramSender(const std::string &address, uint16_t port, std::size_t maximumDatagramSize = 1472, uint32_t maximumBatchSize = 64) noexcept;
+    ~DatagramSender() noexcept;
+
+   public:
+    /**
+     * @return true if the socket could be created.
+     */
+    bool valid() const noexcept;
+
+    /**
+     * This method limits the rate at which the kernel sends this socket's
+     * datagrams using SO_MAX_PACING_RATE; for UDP, this requires the fq
+     * queueing discipline on the outgoing interface.
+     *
+     * @param bitsPerSecond Maximum rate.
+     * @return true if the option could be set.
+     */
+    bool setMaximumPacingRate(uint64_t bitsPerSecond) noexcept;
+
+    /**
+     * This method sends one datagram.
+     *
+     * @param data Datagram to send.
+     * @param length Length of the datagram.
+     * @return (number of bytes sent, error code).
+     */
+    std::pair<ssize_t, int32_t> send(const uint8_t *data, std::size_t length) noexcept;
+
+    /**
+     * This method adds a copy of a datagram to the current batch; a full
+     * batch is sent first.
+     *
+     * @param data Datagram to send.
+     * @param length Length of the datagram.
+     * @return false if the datagram exceeds the maximum datagram size.
+     */
+    bool append(const uint8_t *data, std::size_t length) noexcept;
+
+    /**
+     * This method sends the current batch.
+     *
+     * @return Number of datagrams sent.
+     */
+    uint32_t flush() noexcept;
+
+    /**
+     * @return Maximum number of datagrams in a batch.
+     */
+    uint32_t maximumBatchSize() const noexcept;
+
+    /**
+     * @return true if datagrams of equal size are sent using UDP_SEGMENT.
+     */
+    bool usesSegmentationOffload() const noexcept;
+
+    /**
+     * @return Statistics since the last call.
+     */
+    Statistics statistics() noexcept;
+
+   private:
+    int32_t m_socket{-1};
+    const std::size_t m_maximumDatagramSize;
+    const uint32_t m_maximumBatchSize;
+    // Cleared by the sending thread (e.g., a Pacer's) while others may query it.
+    std::atomic<bool> m_useSegmentationOffload{false};
+
+    // Datagrams of the current batch are stored back-to-back so that
+    // consecutive ones can be passed to the kernel as one buffer.
+    std::vector<uint8_t> m_batch{};
+    std::vector<uint32_t> m_lengths{};
+    std::size_t m_batchLength{0};
+
+    std::vector<struct mmsghdr> m_messages{};
+    std::vector<struct iovec> m_iovecs{};
+    std::vector<uint32_t> m_datagramsPerMessage{};
+    std::vector<uint8_t> m_controls{};
+
+    std::atomic<uint64_t> m_datagrams{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_systemCalls{0};
+    std::atomic<uint64_t> m_failedDatagrams{0};
+};
+
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "envelope-serializer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Proto keys ((fieldIdentifier << 3) | type).
+constexpr uint8_t KEY_VARINT_1{0x08};
+constexpr uint8_t KEY_BYTES_1{0x0A};
+constexpr uint8_t KEY_VARINT_2{0x10};
+constexpr uint8_t KEY_BYTES_2{0x12};
+constexpr uint8_t KEY_VARINT_3{0x18};
+constexpr uint8_t KEY_BYTES_3{0x1A};
+constexpr uint8_t KEY_BYTES_4{0x22};
+constexpr uint8_t KEY_BYTES_5{0x2A};
+constexpr uint8_t KEY_VARINT_6{0x30};
+
+constexpr std::size_t OD4_HEADER_SIZE{5};
+constexpr std::size_t MAX_VARINT_SIZE{10};
+constexpr std::size_t MAX_TIMESTAMP_SIZE{2 + 2 * (1 + 5)};
+// Proto wire types.
+constexpr uint64_t WIRE_TYPE_VARINT{0};
+constexpr uint64_t WIRE_TYPE_FIXED32{5};
+
+uint64_t toZigZag32(int32_t v) noexcept {
+    return static_cast<uint32_t>((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31));
+}
+
+std::size_t varIntSize(uint64_t v) noexcept {
+    std::size_t size{1};
+    while (0x7F < v) {
+        v >>= 7;
+        size++;
+    }
+    return size;
+}
+
+char *putVarInt(char *out, uint64_t v) noexcept {
+    while (0x7F < v) {
+        *out++ = static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    *out++ = static_cast<char>(v & 0x7F);
+    return out;
+}
+
+char *putTimeStamp(char *out, uint8_t key, const cluon::data::TimeStamp &ts) noexcept {
+    const uint64_t SECONDS{toZigZag32(ts.seconds())};
+    const uint64_t MICROSECONDS{toZigZag32(ts.microseconds())};
+    *out++ = static_cast<char>(key);
+    *out++ = static_cast<char>(2 + varIntSize(SECONDS) + varIntSize(MICROSECONDS));
+    *out++ = static_cast<char>(KEY_VARINT_1);
+    out = putVarInt(out, SECONDS);
+    *out++ = static_cast<char>(KEY_VARINT_2);
+    out = putVarInt(out, MICROSECONDS);
+    return out;
+}
+
+char *finishEnvelope(char *begin, char *end) noexcept {
+    const std::size_t PAYLOAD_SIZE{static_cast<std::size_t>(end - begin) - OD4_HEADER_SIZE};
+    begin[0] = static_cast<char>(0x0D);
+    begin[1] = static_cast<char>(0xA4);
+    begin[2] = static_cast<char>(PAYLOAD_SIZE & 0xFF);
+    begin[3] = static_cast<char>((PAYLOAD_SIZE >> 8) & 0xFF);
+    begin[4] = static_cast<char>((PAYLOAD_SIZE >> 16) & 0xFF);
+    return end;
+}
+}
+
+ImageReadingSerializer::ImageReadingSerializer(const std::string &fourcc, uint32_t width, uint32_t height, uint32_t senderStamp, std::size_t maximumDataSize, int32_t dataType) noexcept
+    : m_dataType{dataType} {
+    char tmp[MAX_VARINT_SIZE];
+    m_imageReadingHeader.push_back(static_cast<char>(KEY_BYTES_1));
+    m_imageReadingHeader.append(tmp, putVarInt(tmp, fourcc.size()));
+    m_imageReadingHeader.append(fourcc);
+    m_imageReadingHeader.push_back(static_cast<char>(KEY_VARINT_2));
+    m_imageReadingHeader.append(tmp, putVarInt(tmp, width));
+    m_imageReadingHeader.push_back(static_cast<char>(KEY_VARINT_3));
+    m_imageReadingHeader.append(tmp, putVarInt(tmp, height));
+
+    m_senderStamp.push_back(static_cast<char>(KEY_VARINT_6));
+    m_senderStamp.append(tmp, putVarInt(tmp, senderStamp));
+
+    m_buffer.reserve(OD4_HEADER_SIZE
+                     + 1 + MAX_VARINT_SIZE
+                     + 1 + MAX_VARINT_SIZE + m_imageReadingHeader.size() + 1 + MAX_VARINT_SIZE + maximumDataSize
+                     + 3 * MAX_TIMESTAMP_SIZE
+                     + m_senderStamp.size());
+}
+
+std::string &ImageReadingSerializer::serialize(const uint8_t *data, std::size_t length, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent, const cluon::data::TimeStamp &received) noexcept {
+    const uint64_t DATA_TYPE{toZigZag32(m_dataType)};
+    const std::size_t IMAGE_READING_SIZE{m_imageReadingHeader.size() + 1 + varIntSize(length) + length};
+
+    // resize() only grows within the reserved capacity for expected frame sizes.
+    m_buffer.resize(OD4_HEADER_SIZE
+                    + 1 + varIntSize(DATA_TYPE)
+                    + 1 + varIntSize(IMAGE_READING_SIZE) + IMAGE_READING_SIZE
+                    + 3 * MAX_TIMESTAMP_SIZE
+                    + m_senderStamp.size());
+
+    char *begin = &m_buffer[0];
+    char *out = begin + OD4_HEADER_SIZE;
+    *out++ = static_cast<char>(KEY_VARINT_1);
+    out = putVarInt(out, DATA_TYPE);
+
+    *out++ = static_cast<char>(KEY_BYTES_2);
+    out = putVarInt(out, IMAGE_READING_SIZE);
+    out = std::copy(m_imageReadingHeader.begin(), m_imageReadingHeader.end(), out);
+    *out++ = static_cast<char>(KEY_BYTES_4);
+    out = putVarInt(out, length);
+    if (0 < length) {
+        std::memcpy(out, data, length);
+        out += length;
+    }
+
+    out = putTimeStamp(out, KEY_BYTES_3, sent);
+    out = putTimeStamp(out, KEY_BYTES_4, received);
+    out = putTimeStamp(out, KEY_BYTES_5, sampleTimeStamp);
+    out = std::copy(m_senderStamp.begin(), m_senderStamp.end(), out);
+
+    m_buffer.resize(static_cast<std::size_t>(finishEnvelope(begin, out) - begin));
+    return m_buffer;
+}
+
+VideoMessageSerializer::VideoMessageSerializer(uint32_t senderStamp) noexcept {
+    char tmp[MAX_VARINT_SIZE];
+    m_senderStamp.push_back(static_cast<char>(KEY_VARINT_6));
+    m_senderStamp.append(tmp, putVarInt(tmp, senderStamp));
+
+    m_payload.resize(MAX_FIELDS * (MAX_VARINT_SIZE + MAX_VARINT_SIZE));
+    m_buffer.reserve(OD4_HEADER_SIZE
+                     + 1 + MAX_VARINT_SIZE
+                     + 1 + MAX_VARINT_SIZE + m_payload.size()
+                     + 3 * MAX_TIMESTAMP_SIZE
+                     + m_senderStamp.size());
+}
+
+std::string &VideoMessageSerializer::serialize(const opendlv::video::FrameMetadata &frameMetadata, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept {
+    m_payloadEnd = &m_payload[0];
+    addUnsigned(1, frameMetadata.frameType());
+    addUnsigned(2, frameMetadata.skipReason());
+    addUnsigned(3, frameMetadata.layers());
+    addUnsigned(4, frameMetadata.nalUnits());
+    addUnsigned(5, frameMetadata.size());
+    addUnsigned(6, frameMetadata.averageQp());
+    addUnsigned(7, frameMetadata.queueLatency());
+    addUnsigned(8, frameMetadata.encodeDuration());
+    return finish(opendlv::video::FrameMetadata::ID(), sampleTimeStamp, sent);
+}
+
+std::string &VideoMessageSerializer::serialize(const opendlv::video::UnchangedFrame &unchangedFrame, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept {
+    m_payloadEnd = &m_payload[0];
+    addUnsigned(1, unchangedFrame.skippedFrames());
+    return finish(opendlv::video::UnchangedFrame::ID(), sampleTimeStamp, sent);
+}
+
+std::string &VideoMessageSerializer::serialize(const opendlv::video::QualityReading &qualityReading, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept {
+    m_payloadEnd = &m_payload[0];
+    addUnsigned(1, qualityReading.samples());
+    addFloat(2, qualityReading.meanPsnrY());
+    addFloat(3, qualityReading.minPsnrY());
+    addFloat(4, qualityReading.meanPsnrYuv());
+    addFloat(5, qualityReading.meanSsimY());
+    addFloat(6, qualityReading.minSsimY());
+    addUnsigned(7, qualityReading.droppedFrames());
+    return finish(opendlv::video::QualityReading::ID(), sampleTimeStamp, sent);
+}
+
+std::string &VideoMessageSerializer::serialize(const opendlv::video::EncoderStatistics &encoderStatistics, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept {
+    m_payloadEnd = &m_payload[0];
+    addUnsigned(1, encoderStatistics.inputFrames());
+    addUnsigned(2, encoderStatistics.skippedFrames());
+    addUnsigned(3, encoderStatistics.idrRequests());
+    addUnsigned(4, encoderStatistics.idrFrames());
+    addUnsigned(5, encoderStatistics.ltrFrames());
+    addFloat(6, encoderStatistics.averageFrameRate());
+    addFloat(7, encoderStatistics.latestFrameRate());
+    addUnsigned(8, encoderStatistics.bitrate());
+    addUnsigned(9, encoderStatistics.targetBitrate());
+    addUnsigned(10, encoderStatistics.averageQp());
+    addFloat(11, encoderStatistics.averageEncodingTime());
+    addUnsigned(12, encoderStatistics.totalEncodedBytes());
+    return finish(opendlv::video::EncoderStatistics::ID(), sampleTimeStamp, sent);
+}
+
+void VideoMessageSerializer::addUnsigned(uint32_t fieldIdentifier, uint64_t value) noexcept {
+    // Like cluon::ToProtoVisitor, all fields are encoded including those with default values.
+    m_payloadEnd = putVarInt(m_payloadEnd, (static_cast<uint64_t>(fieldIdentifier) << 3) | WIRE_TYPE_VARINT);
+    m_payloadEnd = putVarInt(m_payloadEnd, value);
+}
+
+void VideoMessageSerializer::addFloat(uint32_t fieldIdentifier, float value) noexcept {
+    uint32_t bits{0};
+    std::memcpy(&bits, &value, sizeof(bits));
+    m_payloadEnd = putVarInt(m_payloadEnd, (static_cast<uint64_t>(fieldIdentifier) << 3) | WIRE_TYPE_FIXED32);
+    for (uint32_t i{0}; i < sizeof(bits); i++) {
+        *m_payloadEnd++ = static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+}
+
+std::string &VideoMessageSerializer::finish(int32_t dataType, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept {
+    const uint64_t DATA_TYPE{toZigZag32(dataType)};
+    const std::size_t PAYLOAD_SIZE{static_cast<std::size_t>(m_payloadEnd - &m_payload[0])};
+
+    // resize() stays within the reserved capacity.
+    m_buffer.resize(OD4_HEADER_SIZE
+                    + 1 + varIntSize(DATA_TYPE)
+                    + 1 + varIntSize(PAYLOAD_SIZE) + PAYLOAD_SIZE
+                    + 3 * MAX_TIMESTAMP_SIZE
+                    + m_senderStamp.size());
+
+    char *begin = &m_buffer[0];
+    char *out = begin + OD4_HEADER_SIZE;
+    *out++ = static_cast<char>(KEY_VARINT_1);
+    out = putVarInt(out, DATA_TYPE);
+
+    *out++ = static_cast<char>(KEY_BYTES_2);
+    out = putVarInt(out, PAYLOAD_SIZE);
+    out = std::copy(&m_payload[0], m_payloadEnd, out);
+
+    out = putTimeStamp(out, KEY_BYTES_3, sent);
+    out = putTimeStamp(out, KEY_BYTES_4, cluon::data::TimeStamp());
+    out = putTimeStamp(out, KEY_BYTES_5, sampleTimeStamp);
+    out = std::copy(m_senderStamp.begin(), m_senderStamp.end(), out);
+
+    m_buffer.resize(static_cast<std::size_t>(finishEnvelope(begin, out) - begin));
+    return m_buffer;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENVELOPE_SERIALIZER_HPP
+#define ENVELOPE_SERIALIZER_HPP
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+#include "opendlv-video-message-set.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * This class serializes opendlv.proxy.ImageReading messages (or messages
+ * sharing its layout) into complete
+ * OD4 envelopes (0x0D 0xA4 LEN0 LEN1 LEN2 + Proto-encoded cluon.data.Envelope)
+ * that are byte-identical to the ones created by cluon::OD4Session::send.
+ *
+ * As fourcc, width, height, and senderStamp do not change for a stream,
+ * their encoding is computed once; for every frame, only the time stamps,
+ * the length fields, and the payload are written into an output buffer that
+ * is reused across frames.
+ */
+class ImageReadingSerializer {
+   private:
+    ImageReadingSerializer(const ImageReadingSerializer &) = delete;
+    ImageReadingSerializer(ImageReadingSerializer &&)      = delete;
+    ImageReadingSerializer &operator=(const ImageReadingSerializer &) = delete;
+    ImageReadingSerializer &operator=(ImageReadingSerializer &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param fourcc FourCC of the image data.
+     * @param width Width of the image.
+     * @param height Height of the image.
+     * @param senderStamp senderStamp for the envelopes.
+     * @param maximumDataSize Largest expected payload to reserve memory for.
+     * @param dataType Message identifier for the envelopes.
+     */
+    ImageReadingSerializer(const std::string &fourcc, uint32_t width, uint32_t height, uint32_t senderStamp, std::size_t maximumDataSize, int32_t dataType = opendlv::proxy::ImageReading::ID()) noexcept;
+
+   public:
+    /**
+     * This method serializes the given image data into an OD4 envelope.
+     *
+     * @param data Image data.
+     * @param length Length of the image data.
+     * @param sampleTimeStamp Time point when the image was captured.
+     * @param sent Time point when the envelope is sent.
+     * @param received Time point when the envelope was received (default: unset).
+     * @return Serialized envelope; it is valid until the next call.
+     */
+    std::string &serialize(const uint8_t *data, std::size_t length, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent, const cluon::data::TimeStamp &received = cluon::data::TimeStamp()) noexcept;
+
+   private:
+    const int32_t m_dataType;
+    std::string m_imageReadingHeader{};
+    std::string m_senderStamp{};
+    std::string m_buffer{};
+};
+
+/**
+ * This class serializes the encoder's small opendlv.video messages into
+ * complete OD4 envelopes like ImageReadingSerializer, so that sending them
+ * for every frame or periodically neither visits the message (which creates
+ * strings for the field names) nor allocates.
+ */
+class VideoMessageSerializer {
+   private:
+    VideoMessageSerializer(const VideoMessageSerializer &) = delete;
+    VideoMessageSerializer(VideoMessageSerializer &&)      = delete;
+    VideoMessageSerializer &operator=(const VideoMessageSerializer &) = delete;
+    VideoMessageSerializer &operator=(VideoMessageSerializer &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param senderStamp senderStamp for the envelopes.
+     */
+    explicit VideoMessageSerializer(uint32_t senderStamp) noexcept;
+
+   public:
+    /**
+     * These methods serialize the given message into an OD4 envelope.
+     *
+     * @param message Message to serialize.
+     * @param sampleTimeStamp Time point of the sample the message refers to.
+     * @param sent Time point when the envelope is sent.
+     * @return Serialized envelope; it is valid until the next call.
+     */
+    std::string &serialize(const opendlv::video::FrameMetadata &message, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept;
+    std::string &serialize(const opendlv::video::UnchangedFrame &message, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept;
+    std::string &serialize(const opendlv::video::QualityReading &message, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept;
+    std::string &serialize(const opendlv::video::EncoderStatistics &message, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept;
+
+   private:
+    // Largest number of fields of the supported messages.
+    static constexpr std::size_t MAX_FIELDS{12};
+
+    void addUnsigned(uint32_t fieldIdentifier, uint64_t value) noexcept;
+    void addFloat(uint32_t fieldIdentifier, float value) noexcept;
+    std::string &finish(int32_t dataType, const cluon::data::TimeStamp &sampleTimeStamp, const cluon::data::TimeStamp &sent) noexcept;
+
+   private:
+    std::string m_senderStamp{};
+    std::string m_payload{};
+    char *m_payloadEnd{nullptr};
+    std::string m_buffer{};
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame-decimator.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+FrameDecimator::FrameDecimator(const std::string &sharedMemoryName, float frameRate) noexcept
+    : m_interval{static_cast<int64_t>(1000.0f * 1000.0f / std::max(frameRate, 0.001f))} {
+    // SysV-based shared memory is time stamped with a token file named like
+    // the shared memory; POSIX-based shared memory with itself in /dev/shm.
+    m_timeStampFile = ::open(sharedMemoryName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (-1 == m_timeStampFile) {
+        m_timeStampFile = ::open(("/dev/shm" + sharedMemoryName).c_str(), O_RDONLY | O_CLOEXEC);
+    }
+}
+
+FrameDecimator::~FrameDecimator() noexcept {
+    if (-1 != m_timeStampFile) {
+        ::close(m_timeStampFile);
+    }
+}
+
+bool FrameDecimator::hasProducerTimeStamps() const noexcept {
+    return (-1 != m_timeStampFile);
+}
+
+bool FrameDecimator::select(cluon::data::TimeStamp &sampleTimeStamp) noexcept {
+    struct stat fileStatus;
+    if ( (-1 != m_timeStampFile) && (0 == ::fstat(m_timeStampFile, &fileStatus)) ) {
+        sampleTimeStamp.seconds(static_cast<int32_t>(fileStatus.st_mtim.tv_sec))
+                       .microseconds(static_cast<int32_t>(fileStatus.st_mtim.tv_nsec / 1000));
+    }
+    const int64_t TIME_STAMP{cluon::time::toMicroseconds(sampleTimeStamp)};
+
+    // The producer's frame interval is smoothed to tolerate jitter.
+    const int64_t DELTA{TIME_STAMP - m_lastTimeStamp};
+    if ( (0 < m_lastTimeStamp) && (0 < DELTA) && (DELTA < 4 * m_interval) ) {
+        m_producerInterval = (0 == m_producerInterval) ? DELTA : m_producerInterval + (DELTA - m_producerInterval) / 8;
+    }
+    m_lastTimeStamp = TIME_STAMP;
+
+    // The next frame would arrive one producer interval later; hence, this
+    // frame is the closest one to the due time when it is less than half an
+    // interval early.
+    if (TIME_STAMP < m_nextDue - m_producerInterval / 2) {
+        // Time stamps far before the due time, for instance after the producer's clock stepped back, restart the cadence.
+        if (TIME_STAMP + 2 * m_interval < m_nextDue) {
+            m_nextDue = TIME_STAMP;
+        }
+        else {
+            m_droppedFrames++;
+            return false;
+        }
+    }
+    m_nextDue = (m_nextDue + m_interval <= TIME_STAMP) ? TIME_STAMP + m_interval : m_nextDue + m_interval;
+    return true;
+}
+
+uint64_t FrameDecimator::droppedFrames() const noexcept {
+    return m_droppedFrames;
+}
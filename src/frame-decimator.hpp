@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_DECIMATOR_HPP
+#define FRAME_DECIMATOR_HPP
+
+#include "cluon-complete.hpp"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * This class selects frames from a shared memory to reduce the producer's
+ * frame rate to a target frame rate with an even cadence. The selection is
+ * based on the producer's time stamps, which cluon keeps as the modification
+ * time of the file behind the shared memory; hence, frames can be dropped
+ * without locking the shared memory.
+ *
+ * A frame is selected when it is the closest one to the next due time, which
+ * advances by one target frame interval per selected frame.
+ */
+class FrameDecimator {
+   private:
+    FrameDecimator(const FrameDecimator &) = delete;
+    FrameDecimator(FrameDecimator &&)      = delete;
+    FrameDecimator &operator=(const FrameDecimator &) = delete;
+    FrameDecimator &operator=(FrameDecimator &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param sharedMemoryName Name of the shared memory as returned by cluon::SharedMemory::name().
+     * @param frameRate Target frame rate.
+     */
+    FrameDecimator(const std::string &sharedMemoryName, float frameRate) noexcept;
+    ~FrameDecimator() noexcept;
+
+   public:
+    /**
+     * @return true if the producer's time stamps are available; otherwise, the time of notification is used.
+     */
+    bool hasProducerTimeStamps() const noexcept;
+
+    /**
+     * This method decides whether to encode the frame that was just notified.
+     *
+     * @param sampleTimeStamp Producer's time stamp of the frame; set when available.
+     * @return true if the frame is selected.
+     */
+    bool select(cluon::data::TimeStamp &sampleTimeStamp) noexcept;
+
+    /**
+     * @return Number of frames not selected.
+     */
+    uint64_t droppedFrames() const noexcept;
+
+   private:
+    const int64_t m_interval;
+    int m_timeStampFile{-1};
+    int64_t m_nextDue{0};
+    int64_t m_lastTimeStamp{0};
+    int64_t m_producerInterval{0};
+    uint64_t m_droppedFrames{0};
+};
+
+#endif
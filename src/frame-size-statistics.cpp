@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame-size-statistics.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+FrameSizeStatistics::FrameSizeStatistics(uint32_t window) noexcept
+    : m_window{std::max(window, 1u)} {
+    for (auto &sizes : m_sizes) {
+        sizes.reserve(m_window);
+    }
+}
+
+bool FrameSizeStatistics::record(uint32_t size, bool isIDR) noexcept {
+    if (m_window <= m_sizes[ALL_FRAMES].size()) {
+        reset();
+    }
+    m_sizes[isIDR ? IDR_FRAMES : OTHER_FRAMES].push_back(size);
+    m_sizes[ALL_FRAMES].push_back(size);
+    return (m_window <= m_sizes[ALL_FRAMES].size());
+}
+
+FrameSizeStatistics::Summary FrameSizeStatistics::summary(Category category) noexcept {
+    Summary s;
+    std::vector<uint32_t> &sizes = m_sizes[category];
+    if (!sizes.empty()) {
+        // Partial sorting reorders the recorded sizes, which does not matter for their distribution.
+        s.m_count = static_cast<uint32_t>(sizes.size());
+        s.m_mean = static_cast<uint32_t>(std::accumulate(sizes.begin(), sizes.end(), static_cast<uint64_t>(0)) / sizes.size());
+        std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+        s.m_median = sizes[sizes.size() / 2];
+        const std::size_t P95{std::min(sizes.size() - 1, (sizes.size() * 95) / 100)};
+        std::nth_element(sizes.begin(), sizes.begin() + P95, sizes.end());
+        s.m_p95 = sizes[P95];
+        s.m_max = *std::max_element(sizes.begin(), sizes.end());
+    }
+    return s;
+}
+
+std::string FrameSizeStatistics::toString() noexcept {
+    const char *NAMES[3]{"IDR", "other", "all"};
+    std::stringstream sstr;
+    for (uint32_t c{IDR_FRAMES}; c <= ALL_FRAMES; c++) {
+        const Summary s{summary(static_cast<Category>(c))};
+        sstr << (IDR_FRAMES == c ? "" : "; ") << NAMES[c] << ": " << s.m_count << " frames, mean = " << s.m_mean << ", median = " << s.m_median << ", p95 = " << s.m_p95 << ", max = " << s.m_max << " bytes";
+        if (0 < s.m_mean) {
+            sstr << ", max/mean = " << std::fixed << std::setprecision(2) << static_cast<float>(s.m_max) / static_cast<float>(s.m_mean);
+        }
+    }
+    return sstr.str();
+}
+
+void FrameSizeStatistics::reset() noexcept {
+    for (auto &sizes : m_sizes) {
+        sizes.clear();
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_SIZE_STATISTICS_HPP
+#define FRAME_SIZE_STATISTICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * This class collects the sizes of encoded frames over a window of frames to
+ * describe their distribution separately for IDR frames, other frames, and
+ * all frames; the ratio between the largest and the mean frame size tells how
+ * far a stream exceeds its average bitrate for single frame periods.
+ */
+class FrameSizeStatistics {
+   private:
+    FrameSizeStatistics(const FrameSizeStatistics &) = delete;
+    FrameSizeStatistics(FrameSizeStatistics &&)      = delete;
+    FrameSizeStatistics &operator=(const FrameSizeStatistics &) = delete;
+    FrameSizeStatistics &operator=(FrameSizeStatistics &&) = delete;
+
+   public:
+    enum Category {
+        IDR_FRAMES = 0,
+        OTHER_FRAMES = 1,
+        ALL_FRAMES = 2,
+    };
+
+    class Summary {
+       public:
+        uint32_t m_count{0};
+        uint32_t m_mean{0};
+        uint32_t m_median{0};
+        uint32_t m_p95{0};
+        uint32_t m_max{0};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param window Number of frames to summarize.
+     */
+    FrameSizeStatistics(uint32_t window) noexcept;
+
+   public:
+    /**
+     * This method records the size of an encoded frame.
+     *
+     * @param size Size of the frame in bytes.
+     * @param isIDR true if the frame is an IDR frame.
+     * @return true if the window is complete.
+     */
+    bool record(uint32_t size, bool isIDR) noexcept;
+
+    /**
+     * @param category Frames to summarize.
+     * @return Distribution of the frame sizes within the current window.
+     */
+    Summary summary(Category category) noexcept;
+
+    /**
+     * @return Human-readable summary of all categories.
+     */
+    std::string toString() noexcept;
+
+    /**
+     * This method starts a new window.
+     */
+    void reset() noexcept;
+
+   private:
+    const uint32_t m_window;
+    std::vector<uint32_t> m_sizes[3];
+};
+
+#endif
@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "image-kernels.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__)
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+namespace {
+constexpr uint32_t BLOCK_SIZE{16};
+
+// SAD of a block that is BLOCK_SIZE pixels wide and 'rows' pixels high.
+#if defined(__x86_64__)
+uint32_t blockSAD16(const uint8_t *a, const uint8_t *b, uint32_t stride, uint32_t rows) noexcept {
+    __m128i sum{_mm_setzero_si128()};
+    for (uint32_t y{0}; y < rows; y++) {
+        const __m128i A{_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * stride))};
+        const __m128i B{_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * stride))};
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(A, B));
+    }
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum)));
+}
+
+// SADs of two horizontally adjacent blocks at once.
+__attribute__((target("avx2")))
+void blockSAD32(const uint8_t *a, const uint8_t *b, uint32_t stride, uint32_t rows, uint32_t &left, uint32_t &right) noexcept {
+    __m256i sum{_mm256_setzero_si256()};
+    for (uint32_t y{0}; y < rows; y++) {
+        const __m256i A{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + y * stride))};
+        const __m256i B{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + y * stride))};
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(A, B));
+    }
+    left = static_cast<uint32_t>(_mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1));
+    right = static_cast<uint32_t>(_mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3));
+}
+
+bool hasAVX2() noexcept {
+    static const bool AVX2{0 != __builtin_cpu_supports("avx2")};
+    return AVX2;
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+uint32_t blockSAD16(const uint8_t *a, const uint8_t *b, uint32_t stride, uint32_t rows) noexcept {
+    uint16x8_t sum{vdupq_n_u16(0)};
+    for (uint32_t y{0}; y < rows; y++) {
+        const uint8x16_t A{vld1q_u8(a + y * stride)};
+        const uint8x16_t B{vld1q_u8(b + y * stride)};
+        // 16 rows of 2 * 255 per lane fit into 16 bits.
+        sum = vpadalq_u8(sum, vabdq_u8(A, B));
+    }
+    const uint32x4_t S4{vpaddlq_u16(sum)};
+    const uint64x2_t S2{vpaddlq_u32(S4)};
+    return static_cast<uint32_t>(vgetq_lane_u64(S2, 0) + vgetq_lane_u64(S2, 1));
+}
+#else
+uint32_t blockSAD16(const uint8_t *a, const uint8_t *b, uint32_t stride, uint32_t rows) noexcept {
+    uint32_t sum{0};
+    for (uint32_t y{0}; y < rows; y++) {
+        for (uint32_t x{0}; x < BLOCK_SIZE; x++) {
+            sum += static_cast<uint32_t>(std::abs(static_cast<int32_t>(a[y * stride + x]) - static_cast<int32_t>(b[y * stride + x])));
+        }
+    }
+    return sum;
+}
+#endif
+
+// Sums of a, b, a*a, b*b, and a*b over one 8x8 block.
+class BlockMoments {
+   public:
+    uint32_t m_sumA{0};
+    uint32_t m_sumB{0};
+    uint32_t m_sumAA{0};
+    uint32_t m_sumBB{0};
+    uint32_t m_sumAB{0};
+};
+
+#if defined(__x86_64__)
+uint64_t rowSSD(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t &x) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    __m128i sum{_mm_setzero_si128()};
+    for (; x + 16 <= width; x += 16) {
+        const __m128i A{_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x))};
+        const __m128i B{_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x))};
+        const __m128i LOW{_mm_sub_epi16(_mm_unpacklo_epi8(A, ZERO), _mm_unpacklo_epi8(B, ZERO))};
+        const __m128i HIGH{_mm_sub_epi16(_mm_unpackhi_epi8(A, ZERO), _mm_unpackhi_epi8(B, ZERO))};
+        // A row of up to 4096 pixels cannot overflow the 32-bit lanes.
+        sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(LOW, LOW), _mm_madd_epi16(HIGH, HIGH)));
+    }
+    const __m128i S64{_mm_add_epi64(_mm_unpacklo_epi32(sum, ZERO), _mm_unpackhi_epi32(sum, ZERO))};
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(S64)) + static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(S64, S64)));
+}
+
+__attribute__((target("avx2")))
+uint64_t rowSSD32(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t &x) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    __m256i sum{_mm256_setzero_si256()};
+    for (; x + 32 <= width; x += 32) {
+        const __m256i A{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x))};
+        const __m256i B{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x))};
+        const __m256i LOW{_mm256_sub_epi16(_mm256_unpacklo_epi8(A, ZERO), _mm256_unpacklo_epi8(B, ZERO))};
+        const __m256i HIGH{_mm256_sub_epi16(_mm256_unpackhi_epi8(A, ZERO), _mm256_unpackhi_epi8(B, ZERO))};
+        sum = _mm256_add_epi32(sum, _mm256_add_epi32(_mm256_madd_epi16(LOW, LOW), _mm256_madd_epi16(HIGH, HIGH)));
+    }
+    const __m256i S64{_mm256_add_epi64(_mm256_unpacklo_epi32(sum, ZERO), _mm256_unpackhi_epi32(sum, ZERO))};
+    return static_cast<uint64_t>(_mm256_extract_epi64(S64, 0) + _mm256_extract_epi64(S64, 1) + _mm256_extract_epi64(S64, 2) + _mm256_extract_epi64(S64, 3));
+}
+
+BlockMoments blockMoments8x8(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    __m128i sumA{_mm_setzero_si128()};
+    __m128i sumB{_mm_setzero_si128()};
+    __m128i sumAA{_mm_setzero_si128()};
+    __m128i sumBB{_mm_setzero_si128()};
+    __m128i sumAB{_mm_setzero_si128()};
+    for (uint32_t y{0}; y < 8; y++) {
+        const __m128i A8{_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + y * strideA))};
+        const __m128i B8{_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + y * strideB))};
+        sumA = _mm_add_epi64(sumA, _mm_sad_epu8(A8, ZERO));
+        sumB = _mm_add_epi64(sumB, _mm_sad_epu8(B8, ZERO));
+        const __m128i A{_mm_unpacklo_epi8(A8, ZERO)};
+        const __m128i B{_mm_unpacklo_epi8(B8, ZERO)};
+        sumAA = _mm_add_epi32(sumAA, _mm_madd_epi16(A, A));
+        sumBB = _mm_add_epi32(sumBB, _mm_madd_epi16(B, B));
+        sumAB = _mm_add_epi32(sumAB, _mm_madd_epi16(A, B));
+    }
+    auto horizontalSum = [](__m128i v) {
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+    };
+    BlockMoments m;
+    m.m_sumA = static_cast<uint32_t>(_mm_cvtsi128_si32(sumA));
+    m.m_sumB = static_cast<uint32_t>(_mm_cvtsi128_si32(sumB));
+    m.m_sumAA = horizontalSum(sumAA);
+    m.m_sumBB = horizontalSum(sumBB);
+    m.m_sumAB = horizontalSum(sumAB);
+    return m;
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+uint64_t rowSSD(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t &x) noexcept {
+    uint32x4_t sum{vdupq_n_u32(0)};
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t D{vabdq_u8(vld1q_u8(a + x), vld1q_u8(b + x))};
+        const uint16x8_t LOW{vmull_u8(vget_low_u8(D), vget_low_u8(D))};
+        const uint16x8_t HIGH{vmull_u8(vget_high_u8(D), vget_high_u8(D))};
+        sum = vpadalq_u16(vpadalq_u16(sum, LOW), HIGH);
+    }
+    const uint64x2_t S2{vpaddlq_u32(sum)};
+    return vgetq_lane_u64(S2, 0) + vgetq_lane_u64(S2, 1);
+}
+
+BlockMoments blockMoments8x8(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB) noexcept {
+    uint16x8_t sumA{vdupq_n_u16(0)};
+    uint16x8_t sumB{vdupq_n_u16(0)};
+    uint32x4_t sumAA{vdupq_n_u32(0)};
+    uint32x4_t sumBB{vdupq_n_u32(0)};
+    uint32x4_t sumAB{vdupq_n_u32(0)};
+    for (uint32_t y{0}; y < 8; y++) {
+        const uint8x8_t A{vld1_u8(a + y * strideA)};
+        const uint8x8_t B{vld1_u8(b + y * strideB)};
+        sumA = vaddw_u8(sumA, A);
+        sumB = vaddw_u8(sumB, B);
+        sumAA = vpadalq_u16(sumAA, vmull_u8(A, A));
+        sumBB = vpadalq_u16(sumBB, vmull_u8(B, B));
+        sumAB = vpadalq_u16(sumAB, vmull_u8(A, B));
+    }
+    auto horizontalSum = [](uint32x4_t v) {
+        const uint64x2_t S2{vpaddlq_u32(v)};
+        return static_cast<uint32_t>(vgetq_lane_u64(S2, 0) + vgetq_lane_u64(S2, 1));
+    };
+    BlockMoments m;
+    m.m_sumA = horizontalSum(vpaddlq_u16(sumA));
+    m.m_sumB = horizontalSum(vpaddlq_u16(sumB));
+    m.m_sumAA = horizontalSum(sumAA);
+    m.m_sumBB = horizontalSum(sumBB);
+    m.m_sumAB = horizontalSum(sumAB);
+    return m;
+}
+#else
+uint64_t rowSSD(const uint8_t *, const uint8_t *, uint32_t, uint32_t &) noexcept {
+    // The remaining pixels are handled by the caller.
+    return 0;
+}
+
+BlockMoments blockMoments8x8(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB) noexcept {
+    BlockMoments m;
+    for (uint32_t y{0}; y < 8; y++) {
+        for (uint32_t x{0}; x < 8; x++) {
+            const uint32_t A{a[y * strideA + x]};
+            const uint32_t B{b[y * strideB + x]};
+            m.m_sumA += A;
+            m.m_sumB += B;
+            m.m_sumAA += A * A;
+            m.m_sumBB += B * B;
+            m.m_sumAB += A * B;
+        }
+    }
+    return m;
+}
+#endif
+
+// Blends 16 or 32 pixels of the previous into the current frame where they differ by less than the threshold.
+#if defined(__x86_64__)
+void temporalDenoise16(const uint8_t *current, uint8_t *filtered, std::size_t length, std::size_t &i, uint8_t strength, uint8_t threshold) noexcept {
+    const __m128i ZERO{_mm_setzero_si128()};
+    const __m128i MAXIMUM_NOISE{_mm_set1_epi8(static_cast<char>(threshold - 1))};
+    const __m128i WEIGHT_CURRENT{_mm_set1_epi16(static_cast<int16_t>(16 - strength))};
+    const __m128i WEIGHT_PREVIOUS{_mm_set1_epi16(static_cast<int16_t>(strength))};
+    const __m128i ROUNDING{_mm_set1_epi16(8)};
+    for (; i + 16 <= length; i += 16) {
+        const __m128i C{_mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i))};
+        const __m128i P{_mm_loadu_si128(reinterpret_cast<const __m128i*>(filtered + i))};
+        const __m128i DIFFERENCE{_mm_or_si128(_mm_subs_epu8(C, P), _mm_subs_epu8(P, C))};
+        const __m128i NOISE{_mm_cmpeq_epi8(_mm_max_epu8(DIFFERENCE, MAXIMUM_NOISE), MAXIMUM_NOISE)};
+        const __m128i LOW{_mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(C, ZERO), WEIGHT_CURRENT), _mm_mullo_epi16(_mm_unpacklo_epi8(P, ZERO), WEIGHT_PREVIOUS)), ROUNDING), 4)};
+        const __m128i HIGH{_mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(C, ZERO), WEIGHT_CURRENT), _mm_mullo_epi16(_mm_unpackhi_epi8(P, ZERO), WEIGHT_PREVIOUS)), ROUNDING), 4)};
+        const __m128i BLENDED{_mm_packus_epi16(LOW, HIGH)};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(filtered + i), _mm_or_si128(_mm_and_si128(NOISE, BLENDED), _mm_andnot_si128(NOISE, C)));
+    }
+}
+
+__attribute__((target("avx2")))
+void temporalDenoise32(const uint8_t *current, uint8_t *filtered, std::size_t length, std::size_t &i, uint8_t strength, uint8_t threshold) noexcept {
+    const __m256i ZERO{_mm256_setzero_si256()};
+    const __m256i MAXIMUM_NOISE{_mm256_set1_epi8(static_cast<char>(threshold - 1))};
+    const __m256i WEIGHT_CURRENT{_mm256_set1_epi16(static_cast<int16_t>(16 - strength))};
+    const __m256i WEIGHT_PREVIOUS{_mm256_set1_epi16(static_cast<int16_t>(strength))};
+    const __m256i ROUNDING{_mm256_set1_epi16(8)};
+    for (; i + 32 <= length; i += 32) {
+        const __m256i C{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + i))};
+        const __m256i P{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(filtered + i))};
+        const __m256i DIFFERENCE{_mm256_or_si256(_mm256_subs_epu8(C, P), _mm256_subs_epu8(P, C))};
+        const __m256i NOISE{_mm256_cmpeq_epi8(_mm256_max_epu8(DIFFERENCE, MAXIMUM_NOISE), MAXIMUM_NOISE)};
+        // Unpacking and packing work within 128-bit lanes; hence, the order of pixels is kept.
+        const __m256i LOW{_mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(C, ZERO), WEIGHT_CURRENT), _mm256_mullo_epi16(_mm256_unpacklo_epi8(P, ZERO), WEIGHT_PREVIOUS)), ROUNDING), 4)};
+        const __m256i HIGH{_mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(C, ZERO), WEIGHT_CURRENT), _mm256_mullo_epi16(_mm256_unpackhi_epi8(P, ZERO), WEIGHT_PREVIOUS)), ROUNDING), 4)};
+        const __m256i BLENDED{_mm256_packus_epi16(LOW, HIGH)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(filtered + i), _mm256_blendv_epi8(C, BLENDED, NOISE));
+    }
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+void temporalDenoise16(const uint8_t *current, uint8_t *filtered, std::size_t length, std::size_t &i, uint8_t strength, uint8_t threshold) noexcept {
+    const uint8x16_t THRESHOLD{vdupq_n_u8(threshold)};
+    const uint8x8_t WEIGHT_CURRENT{vdup_n_u8(static_cast<uint8_t>(16 - strength))};
+    const uint8x8_t WEIGHT_PREVIOUS{vdup_n_u8(strength)};
+    for (; i + 16 <= length; i += 16) {
+        const uint8x16_t C{vld1q_u8(current + i)};
+        const uint8x16_t P{vld1q_u8(filtered + i)};
+        const uint8x16_t NOISE{vcltq_u8(vabdq_u8(C, P), THRESHOLD)};
+        const uint8x8_t LOW{vrshrn_n_u16(vmlal_u8(vmull_u8(vget_low_u8(C), WEIGHT_CURRENT), vget_low_u8(P), WEIGHT_PREVIOUS), 4)};
+        const uint8x8_t HIGH{vrshrn_n_u16(vmlal_u8(vmull_u8(vget_high_u8(C), WEIGHT_CURRENT), vget_high_u8(P), WEIGHT_PREVIOUS), 4)};
+        vst1q_u8(filtered + i, vbslq_u8(NOISE, vcombine_u8(LOW, HIGH), C));
+    }
+}
+#else
+void temporalDenoise16(const uint8_t *, uint8_t *, std::size_t, std::size_t &, uint8_t, uint8_t) noexcept {
+    // The remaining pixels are handled by the caller.
+}
+#endif
+
+// Bilinear interpolation with 7-bit weights; the SIMD variant computes the same.
+inline uint8_t remapBilinearPixel(const uint8_t *source, uint32_t stride, uint32_t offset, const uint8_t *weights) noexcept {
+    const uint32_t FX{weights[0]};
+    const uint32_t FY{weights[1]};
+    const uint32_t TOP{source[offset] * (128 - FX) + source[offset + 1] * FX};
+    const uint32_t BOTTOM{source[offset + stride] * (128 - FX) + source[offset + stride + 1] * FX};
+    return static_cast<uint8_t>((TOP * (128 - FY) + BOTTOM * FY + (1 << 13)) >> 14);
+}
+
+// Remaps eight pixels at once by gathering 32 bits at the upper and lower neighbours.
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+void remapBilinear8(const uint8_t *source, std::size_t sourceLength, uint32_t stride, const uint32_t *offsets, const uint8_t *weights, uint8_t *destination, std::size_t length, std::size_t &i) noexcept {
+    if (sourceLength < static_cast<std::size_t>(stride) + 4) {
+        return;
+    }
+    // Gathering reads two bytes beyond the lower right neighbour.
+    const __m256i LIMIT{_mm256_set1_epi32(static_cast<int32_t>(std::min<std::size_t>(sourceLength - stride - 4, 0x7FFFFFFF)))};
+    const __m256i LOW_BYTE{_mm256_set1_epi32(0xFF)};
+    const __m256i SECOND_BYTE{_mm256_set1_epi32(0xFF00)};
+    const __m256i LOW_WORD{_mm256_set1_epi32(0xFFFF)};
+    const __m256i UNITY{_mm256_set1_epi32(128)};
+    const __m256i ROUNDING{_mm256_set1_epi32(1 << 13)};
+    for (; i + 8 <= length; i += 8) {
+        const __m256i OFFSETS{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + i))};
+        if (0 != _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpgt_epi32(OFFSETS, LIMIT), _mm256_cmpgt_epi32(_mm256_setzero_si256(), OFFSETS)))) {
+            for (std::size_t j{i}; j < i + 8; j++) {
+                destination[j] = remapBilinearPixel(source, stride, offsets[j], weights + 2 * j);
+            }
+            continue;
+        }
+        const __m256i UPPER{_mm256_i32gather_epi32(reinterpret_cast<const int*>(source), OFFSETS, 1)};
+        const __m256i LOWER{_mm256_i32gather_epi32(reinterpret_cast<const int*>(source + stride), OFFSETS, 1)};
+        // Spread the two neighbours and the pairs of weights to 16-bit halves for _mm256_madd_epi16.
+        const __m256i U{_mm256_or_si256(_mm256_and_si256(UPPER, LOW_BYTE), _mm256_slli_epi32(_mm256_and_si256(UPPER, SECOND_BYTE), 8))};
+        const __m256i L{_mm256_or_si256(_mm256_and_si256(LOWER, LOW_BYTE), _mm256_slli_epi32(_mm256_and_si256(LOWER, SECOND_BYTE), 8))};
+        const __m256i W{_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + 2 * i)))};
+        const __m256i FX{_mm256_and_si256(W, LOW_WORD)};
+        const __m256i FY{_mm256_srli_epi32(W, 16)};
+        const __m256i WX{_mm256_or_si256(_mm256_sub_epi32(UNITY, FX), _mm256_slli_epi32(FX, 16))};
+        const __m256i WY{_mm256_or_si256(_mm256_sub_epi32(UNITY, FY), _mm256_slli_epi32(FY, 16))};
+        const __m256i TOP{_mm256_madd_epi16(U, WX)};
+        const __m256i BOTTOM{_mm256_madd_epi16(L, WX)};
+        const __m256i R{_mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_or_si256(TOP, _mm256_slli_epi32(BOTTOM, 16)), WY), ROUNDING), 14)};
+        // Packing works within 128-bit lanes; hence, each lane holds four pixels.
+        const __m256i PACKED{_mm256_packus_epi16(_mm256_packus_epi32(R, R), _mm256_setzero_si256())};
+        const int32_t LEFT{_mm_cvtsi128_si32(_mm256_castsi256_si128(PACKED))};
+        const int32_t RIGHT{_mm_cvtsi128_si32(_mm256_extracti128_si256(PACKED, 1))};
+        memcpy(destination + i, &LEFT, sizeof(LEFT));
+        memcpy(destination + i + 4, &RIGHT, sizeof(RIGHT));
+    }
+}
+#endif
+
+uint32_t blockSADScalar(const uint8_t *a, const uint8_t *b, uint32_t stride, uint32_t columns, uint32_t rows) noexcept {
+    uint32_t sum{0};
+    for (uint32_t y{0}; y < rows; y++) {
+        for (uint32_t x{0}; x < columns; x++) {
+            sum += static_cast<uint32_t>(std::abs(static_cast<int32_t>(a[y * stride + x]) - static_cast<int32_t>(b[y * stride + x])));
+        }
+    }
+    return sum;
+}
+}
+
+uint32_t maximumBlockSAD(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t height, uint32_t limit) noexcept {
+    const uint32_t FULL_COLUMNS{width / BLOCK_SIZE};
+#if defined(__x86_64__)
+    const bool AVX2{hasAVX2()};
+#endif
+    uint32_t maximum{0};
+    for (uint32_t y{0}; y < height; y += BLOCK_SIZE) {
+        const uint32_t ROWS{std::min(BLOCK_SIZE, height - y)};
+        const uint8_t *rowA = a + static_cast<std::size_t>(y) * width;
+        const uint8_t *rowB = b + static_cast<std::size_t>(y) * width;
+
+        // Partial blocks at the bottom and right border are scaled to a full block to be comparable to the limit.
+        uint32_t column{0};
+#if defined(__x86_64__)
+        if (AVX2) {
+            for (; column + 1 < FULL_COLUMNS; column += 2) {
+                uint32_t left{0}, right{0};
+                blockSAD32(rowA + column * BLOCK_SIZE, rowB + column * BLOCK_SIZE, width, ROWS, left, right);
+                maximum = std::max(maximum, (std::max(left, right) * BLOCK_SIZE) / ROWS);
+                if (limit < maximum) {
+                    return maximum;
+                }
+            }
+        }
+#endif
+        for (; column < FULL_COLUMNS; column++) {
+            maximum = std::max(maximum, (blockSAD16(rowA + column * BLOCK_SIZE, rowB + column * BLOCK_SIZE, width, ROWS) * BLOCK_SIZE) / ROWS);
+            if (limit < maximum) {
+                return maximum;
+            }
+        }
+        if (FULL_COLUMNS * BLOCK_SIZE < width) {
+            const uint32_t COLUMNS{width - FULL_COLUMNS * BLOCK_SIZE};
+            const uint32_t SAD{blockSADScalar(rowA + FULL_COLUMNS * BLOCK_SIZE, rowB + FULL_COLUMNS * BLOCK_SIZE, width, COLUMNS, ROWS)};
+            maximum = std::max(maximum, (SAD * BLOCK_SIZE * BLOCK_SIZE) / (COLUMNS * ROWS));
+            if (limit < maximum) {
+                return maximum;
+            }
+        }
+    }
+    return maximum;
+}
+
+uint64_t sumOfSquaredDifferences(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB, uint32_t width, uint32_t height) noexcept {
+#if defined(__x86_64__)
+    const bool AVX2{hasAVX2()};
+#endif
+    uint64_t sum{0};
+    for (uint32_t y{0}; y < height; y++) {
+        const uint8_t *rowA = a + static_cast<std::size_t>(y) * strideA;
+        const uint8_t *rowB = b + static_cast<std::size_t>(y) * strideB;
+        uint32_t x{0};
+#if defined(__x86_64__)
+        if (AVX2) {
+            sum += rowSSD32(rowA, rowB, width, x);
+        }
+#endif
+        sum += rowSSD(rowA, rowB, width, x);
+        for (; x < width; x++) {
+            const int32_t D{static_cast<int32_t>(rowA[x]) - static_cast<int32_t>(rowB[x])};
+            sum += static_cast<uint64_t>(D * D);
+        }
+    }
+    return sum;
+}
+
+double meanSSIM(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB, uint32_t width, uint32_t height) noexcept {
+    constexpr double N{64.0};
+    constexpr double C1{(0.01 * 255) * (0.01 * 255)};
+    constexpr double C2{(0.03 * 255) * (0.03 * 255)};
+    double sum{0.0};
+    uint64_t blocks{0};
+    for (uint32_t y{0}; y + 8 <= height; y += 8) {
+        for (uint32_t x{0}; x + 8 <= width; x += 8) {
+            const BlockMoments M{blockMoments8x8(a + static_cast<std::size_t>(y) * strideA + x, strideA, b + static_cast<std::size_t>(y) * strideB + x, strideB)};
+            const double MEAN_A{M.m_sumA / N};
+            const double MEAN_B{M.m_sumB / N};
+            const double VARIANCE_A{M.m_sumAA / N - MEAN_A * MEAN_A};
+            const double VARIANCE_B{M.m_sumBB / N - MEAN_B * MEAN_B};
+            const double COVARIANCE{M.m_sumAB / N - MEAN_A * MEAN_B};
+            sum += ((2 * MEAN_A * MEAN_B + C1) * (2 * COVARIANCE + C2)) / ((MEAN_A * MEAN_A + MEAN_B * MEAN_B + C1) * (VARIANCE_A + VARIANCE_B + C2));
+            blocks++;
+        }
+    }
+    return (0 < blocks) ? sum / static_cast<double>(blocks) : 1.0;
+}
+
+void temporalDenoise(const uint8_t *current, uint8_t *filtered, std::size_t length, uint8_t strength, uint8_t threshold) noexcept {
+    strength = std::min(strength, static_cast<uint8_t>(15));
+    if ( (0 == strength) || (0 == threshold) ) {
+        memcpy(filtered, current, length);
+        return;
+    }
+    std::size_t i{0};
+#if defined(__x86_64__)
+    if (hasAVX2()) {
+        temporalDenoise32(current, filtered, length, i, strength, threshold);
+    }
+#endif
+    temporalDenoise16(current, filtered, length, i, strength, threshold);
+    for (; i < length; i++) {
+        const int32_t C{current[i]};
+        const int32_t P{filtered[i]};
+        filtered[i] = (std::abs(C - P) < threshold) ? static_cast<uint8_t>((C * (16 - strength) + P * strength + 8) >> 4) : current[i];
+    }
+}
+
+void remapBilinear(const uint8_t *source, std::size_t sourceLength, uint32_t stride, const uint32_t *offsets, const uint8_t *weights, uint8_t *destination, std::size_t length) noexcept {
+    std::size_t i{0};
+#if defined(__x86_64__)
+    if (hasAVX2()) {
+        remapBilinear8(source, sourceLength, stride, offsets, weights, destination, length, i);
+    }
+#else
+    (void)sourceLength;
+#endif
+    for (; i < length; i++) {
+        destination[i] = remapBilinearPixel(source, stride, offsets[i], weights + 2 * i);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGE_KERNELS_HPP
+#define IMAGE_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * This method compares two 8-bit image planes in blocks of 16x16 pixels and
+ * returns the largest sum of absolute differences (SAD) of any block; blocks
+ * at the right and bottom border are scaled to 16x16 pixels. Comparing
+ * blocks instead of whole planes detects small moving objects that would
+ * vanish in a plane-wide average. The comparison stops at the first block
+ * exceeding the given limit.
+ *
+ * SSE2 or AVX2 (selected at runtime) are used on x86-64, NEON on ARM, and
+ * scalar code elsewhere.
+ *
+ * @param a First plane.
+ * @param b Second plane.
+ * @param width Width of the planes (equals their stride).
+ * @param height Height of the planes.
+ * @param limit Stop comparing once a block's SAD exceeds this value.
+ * @return Largest SAD of a 16x16 block (> limit if the comparison stopped early).
+ */
+uint32_t maximumBlockSAD(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t height, uint32_t limit) noexcept;
+
+/**
+ * This method computes the sum of squared differences (SSE) between two
+ * 8-bit image planes, e.g., to compute their PSNR.
+ *
+ * @param a First plane.
+ * @param strideA Stride of the first plane.
+ * @param b Second plane.
+ * @param strideB Stride of the second plane.
+ * @param width Width of the planes.
+ * @param height Height of the planes.
+ * @return Sum of squared differences.
+ */
+uint64_t sumOfSquaredDifferences(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB, uint32_t width, uint32_t height) noexcept;
+
+/**
+ * This method computes the structural similarity (SSIM) between two 8-bit
+ * image planes as mean over non-overlapping 8x8 blocks; incomplete blocks at
+ * the right and bottom border are ignored.
+ *
+ * @param a First plane.
+ * @param strideA Stride of the first plane.
+ * @param b Second plane.
+ * @param strideB Stride of the second plane.
+ * @param width Width of the planes.
+ * @param height Height of the planes.
+ * @return Mean SSIM [-1 .. 1]; 1 for identical planes.
+ */
+double meanSSIM(const uint8_t *a, uint32_t strideA, const uint8_t *b, uint32_t strideB, uint32_t width, uint32_t height) noexcept;
+
+/**
+ * This method applies a motion-adaptive temporal recursive filter: Pixels
+ * that differ from the previously filtered frame by less than the threshold
+ * are considered noise and blended with the previous value; other pixels
+ * are considered motion and passed through unfiltered.
+ *
+ * @param current Current frame.
+ * @param filtered Previously filtered frame; it is replaced by the filtered current frame.
+ * @param length Number of pixels (e.g., all planes of an I420 frame).
+ * @param strength Weight of the previous frame in sixteenths [0 .. 15].
+ * @param threshold Smallest absolute difference considered motion.
+ */
+void temporalDenoise(const uint8_t *current, uint8_t *filtered, std::size_t length, uint8_t strength, uint8_t threshold) noexcept;
+
+/**
+ * This method interpolates pixels bilinearly from a source plane at
+ * precomputed positions.
+ *
+ * @param source Source plane.
+ * @param sourceLength Number of bytes readable from source.
+ * @param stride Stride of the source plane.
+ * @param offsets Offset of the upper left neighbour for every pixel.
+ * @param weights Horizontal and vertical weights of the right and lower neighbours in 128ths [0 .. 128] for every pixel.
+ * @param destination Interpolated pixels.
+ * @param length Number of pixels.
+ */
+void remapBilinear(const uint8_t *source, std::size_t sourceLength, uint32_t stride, const uint32_t *offsets, const uint8_t *weights, uint8_t *destination, std::size_t length) noexcept;
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "key-frame-cache.hpp"
+
+#include <algorithm>
+
+namespace {
+const std::string START_CODE{"\x00\x00\x00\x01", 4};
+}
+
+KeyFrameCache::KeyFrameCache(std::size_t maximumSize, uint32_t maximumFrames) noexcept
+    : m_maximumSize{maximumSize}
+    , m_maximumFrames{maximumFrames} {
+    m_frames.reserve(std::min(m_maximumFrames, 1024u));
+    m_buffers.reserve(std::min(m_maximumFrames, 1024u));
+}
+
+void KeyFrameCache::update(const uint8_t *data, std::size_t length, const NalUnit *nalUnits, std::size_t numberOfNalUnits, bool isIDR, const cluon::data::TimeStamp &sampleTimeStamp) noexcept {
+    bool hasSPS{false};
+    bool hasPPS{false};
+    for (std::size_t i{0}; i < numberOfNalUnits; i++) {
+        if (NalUnit::SPS == nalUnits[i].type()) {
+            m_sps.assign(START_CODE).append(reinterpret_cast<const char*>(nalUnits[i].m_data), nalUnits[i].m_length);
+            hasSPS = true;
+        }
+        else if (NalUnit::PPS == nalUnits[i].type()) {
+            m_pps.assign(START_CODE).append(reinterpret_cast<const char*>(nalUnits[i].m_data), nalUnits[i].m_length);
+            hasPPS = true;
+        }
+    }
+
+    if (isIDR) {
+        m_frames.clear();
+        m_size = 0;
+        m_complete = true;
+    }
+    if (!m_complete) {
+        return;
+    }
+
+    const std::size_t PARAMETER_SETS_SIZE{((isIDR && !hasSPS) ? m_sps.size() : 0) + ((isIDR && !hasPPS) ? m_pps.size() : 0)};
+    if ( (m_maximumFrames <= m_frames.size()) || (m_maximumSize < m_size + PARAMETER_SETS_SIZE + length) ) {
+        // Release the cached access units to not serve an undecodable sequence.
+        m_frames.clear();
+        m_size = 0;
+        m_complete = false;
+        return;
+    }
+
+    if (m_buffers.size() == m_frames.size()) {
+        m_buffers.emplace_back(new std::string{});
+    }
+    std::string *buffer{m_buffers[m_frames.size()].get()};
+    buffer->clear();
+    if (isIDR && !hasSPS) {
+        buffer->append(m_sps);
+    }
+    if (isIDR && !hasPPS) {
+        buffer->append(m_pps);
+    }
+    buffer->append(reinterpret_cast<const char*>(data), length);
+    m_size += buffer->size();
+    m_frames.push_back(Frame{buffer, sampleTimeStamp});
+}
+
+bool KeyFrameCache::isComplete() const noexcept {
+    return m_complete && !m_frames.empty();
+}
+
+const std::vector<KeyFrameCache::Frame> &KeyFrameCache::frames() const noexcept {
+    return m_frames;
+}
+
+const std::string &KeyFrameCache::sps() const noexcept {
+    return m_sps;
+}
+
+const std::string &KeyFrameCache::pps() const noexcept {
+    return m_pps;
+}
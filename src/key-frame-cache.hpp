@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEY_FRAME_CACHE_HPP
+#define KEY_FRAME_CACHE_HPP
+
+#include "cluon-complete.hpp"
+#include "nal-unit.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * This class retains the most recent IDR access unit together with all
+ * access units encoded since, so that consumers joining mid-GOP can start
+ * decoding immediately and without drift instead of waiting for the next IDR
+ * frame. The latest SPS and PPS are retained as well and are prepended to a
+ * cached IDR access unit that does not carry them itself.
+ *
+ * When the access units since the last IDR frame exceed the given limits, the
+ * cache is incomplete until the next IDR frame.
+ *
+ * The cached access units are kept in buffers that are reused in order;
+ * hence, a Frame's data is only valid until the next call to update().
+ */
+class KeyFrameCache {
+   private:
+    KeyFrameCache(const KeyFrameCache &) = delete;
+    KeyFrameCache(KeyFrameCache &&)      = delete;
+    KeyFrameCache &operator=(const KeyFrameCache &) = delete;
+    KeyFrameCache &operator=(KeyFrameCache &&) = delete;
+
+   public:
+    class Frame {
+       public:
+        const std::string *m_data;
+        cluon::data::TimeStamp m_sampleTimeStamp;
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param maximumSize Maximum number of bytes to retain.
+     * @param maximumFrames Maximum number of access units to retain.
+     */
+    KeyFrameCache(std::size_t maximumSize, uint32_t maximumFrames) noexcept;
+
+   public:
+    /**
+     * This method adds an encoded access unit.
+     *
+     * @param data Annex-B access unit.
+     * @param length Length of the access unit.
+     * @param nalUnits NAL units of the access unit.
+     * @param numberOfNalUnits Number of NAL units.
+     * @param isIDR true if the access unit is an IDR frame.
+     * @param sampleTimeStamp Time point when the frame was captured.
+     */
+    void update(const uint8_t *data, std::size_t length, const NalUnit *nalUnits, std::size_t numberOfNalUnits, bool isIDR, const cluon::data::TimeStamp &sampleTimeStamp) noexcept;
+
+    /**
+     * @return true if the cache starts with an IDR frame and holds all access units since.
+     */
+    bool isComplete() const noexcept;
+
+    /**
+     * @return Cached access units starting with the latest IDR frame.
+     */
+    const std::vector<Frame> &frames() const noexcept;
+
+    /**
+     * @return Latest sequence parameter set seen (Annex-B).
+     */
+    const std::string &sps() const noexcept;
+
+    /**
+     * @return Latest picture parameter set seen (Annex-B).
+     */
+    const std::string &pps() const noexcept;
+
+   private:
+    const std::size_t m_maximumSize;
+    const uint32_t m_maximumFrames;
+
+    std::vector<Frame> m_frames{};
+    // The i-th cached access unit is kept in the i-th buffer.
+    std::vector<std::unique_ptr<std::string>> m_buffers{};
+    std::size_t m_size{0};
+    bool m_complete{false};
+
+    std::string m_sps{};
+    std::string m_pps{};
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NAL_UNIT_HPP
+#define NAL_UNIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * This class refers to one h264 NAL unit (without Annex-B start code)
+ * residing in a buffer owned by somebody else.
+ */
+class NalUnit {
+   public:
+    enum Type : uint8_t {
+        SLICE = 1,
+        IDR = 5,
+        SEI = 6,
+        SPS = 7,
+        PPS = 8,
+    };
+
+   public:
+    /**
+     * This method creates a NalUnit from an Annex-B formatted NAL unit as
+     * delivered by openh264 (i.e., prefixed by 00 00 01 or 00 00 00 01).
+     *
+     * @param data Annex-B NAL unit.
+     * @param length Length including the start code.
+     * @return NAL unit without start code.
+     */
+    static NalUnit fromAnnexB(const uint8_t *data, std::size_t length) noexcept {
+        std::size_t startCode{0};
+        while ( (startCode + 1 < length) && (0 == data[startCode]) ) {
+            startCode++;
+        }
+        if ( (2 <= startCode) && (1 == data[startCode]) ) {
+            startCode++;
+        }
+        else {
+            startCode = 0;
+        }
+        return NalUnit{data + startCode, length - startCode};
+    }
+
+    uint8_t type() const noexcept {
+        return (0 < m_length) ? (m_data[0] & 0x1F) : 0;
+    }
+
+   public:
+    const uint8_t *m_data;
+    std::size_t m_length;
+};
+
+#endif
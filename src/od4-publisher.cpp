@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "od4-publisher.hpp"
+
+#include <sstream>
+
+OD4Publisher::OD4Publisher(uint16_t CID) noexcept
+    : m_address{"225.0.0." + std::to_string(CID)}
+    , m_sender{m_address, 12175} {
+    // Register the signal handlers for SIGINT and SIGTERM as OD4Session does.
+    cluon::TerminateHandler::instance();
+}
+
+bool OD4Publisher::dataTrigger(int32_t messageIdentifier, std::function<void(cluon::data::Envelope &&envelope)> delegate) noexcept {
+    if (nullptr == delegate) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lck{m_mapOfDataTriggeredDelegatesMutex};
+        m_mapOfDataTriggeredDelegates[messageIdentifier] = delegate;
+    }
+    if (nullptr == m_receiver) {
+        m_receiver.reset(new cluon::UDPReceiver{
+            m_address,
+            12175,
+            [this](std::string &&data, std::string &&from, std::chrono::system_clock::time_point &&timepoint) {
+                this->callback(std::move(data), std::move(from), std::move(timepoint));
+            },
+            m_sender.getSendFromPort() /* passing our local send from port to the UDPReceiver to filter out our own bytes */});
+    }
+    return m_receiver->isRunning();
+}
+
+std::pair<ssize_t, int32_t> OD4Publisher::send(std::string &&envelope) noexcept {
+    return m_sender.send(std::move(envelope));
+}
+
+bool OD4Publisher::isRunning() noexcept {
+    return !cluon::TerminateHandler::instance().isTerminated.load() && ((nullptr == m_receiver) || m_receiver->isRunning());
+}
+
+void OD4Publisher::callback(std::string &&data, std::string && /*from*/, std::chrono::system_clock::time_point &&timepoint) noexcept {
+    // An OD4 envelope starts with 0x0D 0xA4 LEN0 LEN1 LEN2 followed by the
+    // Proto-encoded cluon.data.Envelope, whose first field is the varint dataType.
+    constexpr std::size_t OD4_HEADER_SIZE{5};
+    if ( (OD4_HEADER_SIZE + 2 > data.size()) || (0x0D != static_cast<uint8_t>(data[0])) || (0xA4 != static_cast<uint8_t>(data[1])) || (0x08 != static_cast<uint8_t>(data[OD4_HEADER_SIZE])) ) {
+        return;
+    }
+    uint64_t zigZag{0};
+    for (std::size_t i{OD4_HEADER_SIZE + 1}, shift{0}; (i < data.size()) && (shift < 35); i++, shift += 7) {
+        const uint8_t b{static_cast<uint8_t>(data[i])};
+        zigZag |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (0 == (b & 0x80)) {
+            break;
+        }
+    }
+    const int32_t DATA_TYPE{static_cast<int32_t>((zigZag >> 1) ^ (~(zigZag & 1) + 1))};
+
+    std::function<void(cluon::data::Envelope &&envelope)> delegate{nullptr};
+    {
+        std::lock_guard<std::mutex> lck{m_mapOfDataTriggeredDelegatesMutex};
+        auto entry = m_mapOfDataTriggeredDelegates.find(DATA_TYPE);
+        if (entry == m_mapOfDataTriggeredDelegates.end()) {
+            return;
+        }
+        delegate = entry->second;
+    }
+
+    std::stringstream sstr(data);
+    auto retVal = cluon::extractEnvelope(sstr);
+    if (retVal.first) {
+        cluon::data::Envelope envelope{retVal.second};
+        envelope.received(cluon::time::convert(timepoint));
+        delegate(std::move(envelope));
+    }
+}
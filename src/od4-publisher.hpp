@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OD4_PUBLISHER_HPP
+#define OD4_PUBLISHER_HPP
+
+#include "cluon-complete.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * This class is a publisher-oriented counterpart to cluon::OD4Session.
+ *
+ * cluon::OD4Session always joins the session's multicast group and thus
+ * receives every envelope on the bus, including the h264 frames of all other
+ * cameras. This class only sends until a data-triggered delegate is
+ * registered; only then it joins the multicast group, and it inspects the
+ * dataType of incoming envelopes before deserializing them so that
+ * unrelated envelopes are discarded without being parsed.
+ */
+class OD4Publisher {
+   private:
+    OD4Publisher(const OD4Publisher &) = delete;
+    OD4Publisher(OD4Publisher &&)      = delete;
+    OD4Publisher &operator=(const OD4Publisher &) = delete;
+    OD4Publisher &operator=(OD4Publisher &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param CID OpenDaVINCI v4 session identifier [1 .. 254]
+     */
+    OD4Publisher(uint16_t CID) noexcept;
+
+   public:
+    /**
+     * This method sets a delegate to be called on arrival of a new Envelope
+     * for the given message identifier; the first call joins the multicast group.
+     *
+     * @param messageIdentifier Message identifier to assign a delegate.
+     * @param delegate Function to call on newly arriving Envelopes.
+     * @return true if the delegate could be set.
+     */
+    bool dataTrigger(int32_t messageIdentifier, std::function<void(cluon::data::Envelope &&envelope)> delegate) noexcept;
+
+    /**
+     * This method sends an already serialized envelope.
+     *
+     * @param envelope Serialized envelope; it is only read from.
+     * @return (number of bytes sent, error code).
+     */
+    std::pair<ssize_t, int32_t> send(std::string &&envelope) noexcept;
+
+    /**
+     * This method will send a given message to this OpenDaVINCI v4 session.
+     *
+     * @param message Message to be sent.
+     * @param sampleTimeStamp Time point when this sample to be sent was captured (default = sent time point).
+     * @param senderStamp Optional sender stamp (default = 0).
+     */
+    template <typename T>
+    void send(T &message, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept {
+        cluon::ToProtoVisitor protoEncoder;
+        message.accept(protoEncoder);
+
+        cluon::data::Envelope envelope;
+        envelope.dataType(static_cast<int32_t>(message.ID()))
+                .serializedData(protoEncoder.encodedData())
+                .sent(cluon::time::now())
+                .sampleTimeStamp((0 == (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())) ? envelope.sent() : sampleTimeStamp)
+                .senderStamp(senderStamp);
+        send(cluon::serializeEnvelope(std::move(envelope)));
+    }
+
+    /**
+     * @return true while the session is usable and no termination was requested.
+     */
+    bool isRunning() noexcept;
+
+   private:
+    void callback(std::string &&data, std::string &&from, std::chrono::system_clock::time_point &&timepoint) noexcept;
+
+   private:
+    const std::string m_address;
+    cluon::UDPSender m_sender;
+    std::unique_ptr<cluon::UDPReceiver> m_receiver{nullptr};
+
+    std::mutex m_mapOfDataTriggeredDelegatesMutex{};
+    std::unordered_map<int32_t, std::function<void(cluon::data::Envelope &&envelope)>, cluon::UseUInt32ValueAsHashKey> m_mapOfDataTriggeredDelegates{};
+};
+
+#endif
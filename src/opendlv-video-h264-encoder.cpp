@@ -17,13 +17,41 @@
 
 #include "cluon-complete.hpp"
 #include "opendlv-standard-message-set.hpp"
+#include "opendlv-video-message-set.hpp"
+#include "bitrate-arbiter.hpp"
+#include "buffer-pool.hpp"
+#include "datagram-sender.hpp"
+#include "envelope-serializer.hpp"
+#include "frame-decimator.hpp"
+#include "frame-size-statistics.hpp"
+#include "image-kernels.hpp"
+#include "key-frame-cache.hpp"
+#include "od4-publisher.hpp"
+#include "pacer.hpp"
+#include "quality-monitor.hpp"
+#include "realtime-tuning.hpp"
+#include "recorder.hpp"
+#include "remapper.hpp"
+#include "rtp-fec.hpp"
+#include "rtp-packetizer.hpp"
+#include "shared-memory-sink.hpp"
+#include "tcp-stream-server.hpp"
 
 #include <wels/codec_api.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 
@@ -35,10 +63,15 @@ int32_t main(int32_t argc, char **argv) {
          (0 == commandlineArguments.count("width")) ||
          (0 == commandlineArguments.count("height")) ) {
         std::cerr << argv[0] << " attaches to an I420-formatted image residing in a shared memory area to convert it into a corresponding h264 frame for publishing to a running OD4 session." << std::endl;
-        std::cerr << "Usage:   " << argv[0] << " --cid=<OpenDaVINCI session> --name=<name of shared memory area> --width=<width> --height=<height> [--gop=<GOP>] [--bitrate=<bitrate>] [--id=<identifier in case of multiple instances]"
+        std::cerr << "Usage:   " << argv[0] << " --cid=<OpenDaVINCI session> --name=<name of shared memory area> --width=<width> --height=<height> [--gray] [--gop=<GOP>] [--target-fps=<fps>] [--bitrate=<bitrate>] [--id=<identifier in case of multiple instances]"
                 "[--bitrate-max=<bitrate-max>] [--rc-mode=<rc-mode>] [--ecomplexity=<ecomplexity>] [--sps-pps=<sps-pps>] [--num-ref-frame=<num-ref-frame>] [--ssei=<ssei>] [--prefix-nal=<prefix-nal>] [--entropy-coding=<entropy-coding>] "
-                "[--frame-skip=<frame-skip>] [--qp-max=<qp-max>] [--qp-min=<qp-min>] [--long-term-ref=<long-term-ref>] [--loop-filter=<loop-filter>] [--denoise=<denoise>] [--background-detection=<background-detection>] "
-                "[--adaptive-quant=<adaptive-quant>] [--frame-cropping=<frame-cropping>] [--scene-change-detect=<scene-change-detect>] [--threads=<threads>] [--verbose]" << std::endl;
+                "[--frame-skip=<frame-skip>] [--qp-max=<qp-max>] [--qp-min=<qp-min>] [--long-term-ref=<long-term-ref>] [--loop-filter=<loop-filter>] [--denoise=<denoise>] [--remap=<file>] [--temporal-denoise=<strength>] [--temporal-denoise-threshold=<threshold>] [--background-detection=<background-detection>] "
+                "[--adaptive-quant=<adaptive-quant>] [--frame-cropping=<frame-cropping>] [--scene-change-detect=<scene-change-detect>] [--threads=<threads>] "
+                "[--cpu-affinity=<cpus>] [--encoder-cpu-affinity=<cpus>] [--rt-priority=<priority>] [--huge-pages=<huge-pages>] "
+                "[--shm-output=<name>] [--shm-output-slots=<slots>] [--rec=<file>] [--rec-max-size=<MB>] [--rec-max-duration=<seconds>] [--rec-direct-io=<rec-direct-io>] "
+                "[--rtp=<ip:port>] [--rtp-mtu=<bytes>] [--rtp-packetization-mode=<mode>] [--rtp-payload-type=<type>] [--rtp-sdp=<file>] [--rtp-pacing-rate=<bitrate>] [--rtp-pacing-burst=<bytes>] [--rtp-pacing-kernel=<rtp-pacing-kernel>] [--rtp-fec=<percent>] [--tcp-port=<port>] [--tcp-queue=<frames>] [--keyframe-request-interval=<ms>] [--ltr-feedback] [--keyframe-cache=<MB>] [--frame-size-stats=<frames>] "
+                "[--static-scene-threshold=<threshold>] [--static-scene-keepalive=<frames>] "
+                "[--bitrate-budget=<bitrate>] [--bitrate-group=<name>] [--bitrate-priority=<priority>] [--quality-monitor=<frames>] [--quality-window=<frames>] [--frame-metadata] [--encoder-stats=<ms>] [--verbose]" << std::endl;
         std::cerr << "         --cid:           CID of the OD4Session to send h264 frames" << std::endl;
         std::cerr << "         --id:            when using several instances, this identifier is used as senderStamp" << std::endl;
         std::cerr << "         --name:          name of the shared memory area to attach" << std::endl;
@@ -46,7 +79,9 @@ int32_t main(int32_t argc, char **argv) {
         std::cerr << "         --height:        height of the frame" << std::endl;
         std::cerr << "         --bitrate:       optional: desired bitrate (default: 1,500,000, min: 100,000 max: 5,000,000)" << std::endl;
         std::cerr << "         --bitrate-max:   optional: maximum bitrate (default: 5,000,000, min: 100,000 max: 5,000,000)" << std::endl;
-        std::cerr << "         --gop:           optional: length of group of pictures (default = 10)" << std::endl;
+        std::cerr << "         --gray:          optional: the shared memory holds 8-bit grayscale (Y only) instead of I420 frames; they are encoded with constant chroma" << std::endl;
+        std::cerr << "         --gop:           optional: length of group of pictures (default = 10, 0: only the first frame is an IDR frame)" << std::endl;
+        std::cerr << "         --target-fps:    optional: encode only frames closest to an even cadence at this frame rate selected by the producer's time stamps without locking the shared memory for the others (default: 0 = every frame)" << std::endl;
         std::cerr << "         --rc-mode:       optional: rate control mode (default: RC_QUALITY_MODE (0), min: 0, max: 4)" << std::endl;
         std::cerr << "         --ecomplexity:   optional: complexity mode (default: LOW_COMPLEXITY (0), min: 0, max: 2)" << std::endl;
         std::cerr << "         --sps-pps:       optional: SPS/PPS strategy (default: CONSTANT_ID (0), min: 0, max: 3)" << std::endl;
@@ -60,11 +95,48 @@ int32_t main(int32_t argc, char **argv) {
         std::cerr << "         --long-term-ref: optional: toggle long term reference control (default: 0)" << std::endl;
         std::cerr << "         --loop-filter:   optional: deblocking loop filter (default: 0, 0: on, 1: off, 2: on except for slice boundaries)" << std::endl;
         std::cerr << "         --denoise:       optional: toggle denoise control (default: 0)" << std::endl;
+        std::cerr << "         --remap:         optional: undistort or rectify frames before encoding with a lookup table of width * height pairs of 32-bit floats (x, y) with the source position of every pixel (e.g., from OpenCV's initUndistortRectifyMap with CV_32FC2)" << std::endl;
+        std::cerr << "         --temporal-denoise: optional: blend static pixels with the previous frame before encoding to remove sensor noise; weight of the previous frame in sixteenths (default: 0 = off, max: 15)" << std::endl;
+        std::cerr << "         --temporal-denoise-threshold: optional: smallest difference to the previous frame considered motion and not filtered by --temporal-denoise (default: 8)" << std::endl;
         std::cerr << "         --background-detection: optional: toggle background detection control (default: 1)" << std::endl;
         std::cerr << "         --adaptive-quant: optional: toggle adaptive quantization control (default: 1)" << std::endl;
         std::cerr << "         --frame-cropping: optional: toggle frame cropping (default: 1)" << std::endl;
         std::cerr << "         --scene-change-detect: optional: toggle scene change detection control (default: 1)" << std::endl;
         std::cerr << "         --threads        :optional: number of threads (default: 1, O: auto, >1: number of theads, max 4)" << std::endl;
+        std::cerr << "         --cpu-affinity:  optional: CPUs to run capturing, encoding, and publishing on (e.g., 2-3); buffers are placed on the NUMA node of the first CPU" << std::endl;
+        std::cerr << "         --encoder-cpu-affinity: optional: CPUs to run openh264's worker threads on (default: --cpu-affinity)" << std::endl;
+        std::cerr << "         --rt-priority:   optional: run capturing, encoding, and publishing with SCHED_FIFO at the given priority (min: 1, max: 99; requires CAP_SYS_NICE)" << std::endl;
+        std::cerr << "         --huge-pages:    optional: toggle 2 MB huge pages for pre-faulted frame and bitstream buffers (default: 0)" << std::endl;
+        std::cerr << "         --shm-output:    optional: name of a shared memory area to additionally publish h264 frames to for consumers on the same host" << std::endl;
+        std::cerr << "         --shm-output-slots: optional: number of h264 frames kept in --shm-output (default: 4, min: 2)" << std::endl;
+        std::cerr << "         --rec:           optional: additionally record the published h264 frames to this .rec file" << std::endl;
+        std::cerr << "         --rec-max-size:  optional: start a new .rec file (named with a time stamp) when the current one exceeds this size in MB (default: 0 = never)" << std::endl;
+        std::cerr << "         --rec-max-duration: optional: start a new .rec file (named with a time stamp) after this many seconds (default: 0 = never)" << std::endl;
+        std::cerr << "         --rec-direct-io: optional: toggle O_DIRECT to bypass the page cache when recording (default: 1)" << std::endl;
+        std::cerr << "         --rtp:           optional: additionally send h264 frames as RTP (RFC 6184) to this address (e.g., 239.255.0.1:5004)" << std::endl;
+        std::cerr << "         --rtp-mtu:       optional: maximum size of RTP packets (default: 1400, min: 128, max: 65507)" << std::endl;
+        std::cerr << "         --rtp-packetization-mode: optional: 0: single NAL unit (slices limited to --rtp-mtu), 1: non-interleaved with STAP-A and FU-A (default: 1)" << std::endl;
+        std::cerr << "         --rtp-payload-type: optional: dynamic RTP payload type (default: 96, min: 96, max: 127)" << std::endl;
+        std::cerr << "         --rtp-sdp:       optional: write an SDP file describing the RTP stream for players like VLC, ffplay, or GStreamer" << std::endl;
+        std::cerr << "         --rtp-pacing-rate: optional: spread RTP packets over time at this rate in bits per second to avoid bursts from large frames (default: 0 = off)" << std::endl;
+        std::cerr << "         --rtp-pacing-burst: optional: maximum number of bytes sent back-to-back when pacing (default: 4 * --rtp-mtu)" << std::endl;
+        std::cerr << "         --rtp-pacing-kernel: optional: let the kernel pace using SO_MAX_PACING_RATE (requires the fq qdisc) instead of a pacing thread (default: 0)" << std::endl;
+        std::cerr << "         --rtp-fec:       optional: send XOR parity packets to the RTP port + 2 with this overhead in percent so that receivers can restore one lost packet per group (e.g., 10; default: 0 = off)" << std::endl;
+        std::cerr << "         --tcp-port:      optional: additionally stream h264 frames (Annex-B) to TCP clients connecting to this port" << std::endl;
+        std::cerr << "         --tcp-queue:     optional: number of h264 frames queued per TCP client before its queue is dropped until the next IDR frame (default: 10)" << std::endl;
+        std::cerr << "         --keyframe-request-interval: optional: force an IDR frame on opendlv.video.KeyFrameRequest (senderStamp = --id) at most once per this many milliseconds (default: 0 = ignore requests); with --gop=0, TCP clients and key frame cache requests waiting for an IDR frame force one at most once per this interval but at least 1000 ms regardless" << std::endl;
+        std::cerr << "         --ltr-feedback:  optional: recover from losses reported by opendlv.video.LTRRecoveryRequest and opendlv.video.LTRMarkingFeedback (senderStamp = --id) using long-term reference frames instead of IDR frames; enables --long-term-ref" << std::endl;
+        std::cerr << "         --keyframe-cache: optional: retain up to this many MB of h264 frames since the latest IDR frame to start new TCP clients and consumers sending opendlv.video.KeyFrameCacheRequest immediately (default: 0 = off)" << std::endl;
+        std::cerr << "         --frame-size-stats: optional: print the distribution of frame sizes for IDR and other frames every this many frames (default: 0 = off)" << std::endl;
+        std::cerr << "         --static-scene-threshold: optional: skip encoding a frame when no 16x16 block differs from the last encoded frame by more than this mean absolute difference per pixel (e.g., 1.5; default: 0 = off)" << std::endl;
+        std::cerr << "         --static-scene-keepalive: optional: encode at least every this many frames when the scene is static (default: 20)" << std::endl;
+        std::cerr << "         --bitrate-budget: optional: total bitrate shared with all encoders of --bitrate-group on this host by scene complexity and priority; replaces --bitrate after the first update (default: 0 = off)" << std::endl;
+        std::cerr << "         --bitrate-group: optional: name of the group of encoders sharing --bitrate-budget (default: cid-<cid>)" << std::endl;
+        std::cerr << "         --bitrate-priority: optional: weight of this encoder in its group (default: 1.0)" << std::endl;
+        std::cerr << "         --quality-monitor: optional: decode the h264 frames in a background thread and compare every this many frames against their source frame (default: 0 = off)" << std::endl;
+        std::cerr << "         --quality-window: optional: number of compared frames summarized in one opendlv.video.QualityReading (default: 10)" << std::endl;
+        std::cerr << "         --frame-metadata: optional: send opendlv.video.FrameMetadata with type, size, QP, and latencies of every frame" << std::endl;
+        std::cerr << "         --encoder-stats: optional: send openh264's statistics as opendlv.video.EncoderStatistics every this many milliseconds (default: 0 = off)" << std::endl;
         std::cerr << "         --verbose: print encoding information" << std::endl;
         std::cerr << "Example: " << argv[0] << " --cid=111 --name=data --width=640 --height=480 --verbose" << std::endl;
     }
@@ -72,8 +144,12 @@ int32_t main(int32_t argc, char **argv) {
         const std::string NAME{commandlineArguments["name"]};
         const uint32_t WIDTH{static_cast<uint32_t>(std::stoi(commandlineArguments["width"]))};
         const uint32_t HEIGHT{static_cast<uint32_t>(std::stoi(commandlineArguments["height"]))};
+        const bool GRAY{commandlineArguments.count("gray") != 0};
+        // Number of bytes read from the shared memory per frame.
+        const std::size_t INPUT_FRAME_SIZE{static_cast<std::size_t>(WIDTH) * HEIGHT * (GRAY ? 2 : 3) / 2};
         const uint32_t GOP_DEFAULT{10};
         const uint32_t GOP{(commandlineArguments["gop"].size() != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["gop"])) : GOP_DEFAULT};
+        const float TARGET_FPS{(commandlineArguments["target-fps"].size() != 0) ? std::max(std::stof(commandlineArguments["target-fps"]), 0.0f) : 0.0f};
         const uint32_t BITRATE_MIN{100000};
         const uint32_t BITRATE_DEFAULT{1500000};
         const uint32_t BITRATE_MAX{5000000};
@@ -104,16 +180,249 @@ int32_t main(int32_t argc, char **argv) {
         const uint32_t B_LONG_TERM_REFERENCE{(commandlineArguments["long-term-ref"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["long-term-ref"])), ZERO), ONE): 0};
         const uint32_t I_LOOP_FILTER{(commandlineArguments["loop-filter"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["loop-filter"])), ZERO), TWO): 0};
         const uint32_t B_DENOISE{(commandlineArguments["denoise"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["denoise"])), ZERO), ONE): 0};
+        const std::string REMAP{commandlineArguments["remap"]};
+        const uint32_t TEMPORAL_DENOISE{(commandlineArguments["temporal-denoise"].size() != 0) ? std::min(static_cast<uint32_t>(std::stoi(commandlineArguments["temporal-denoise"])), 15u) : 0};
+        const uint32_t TEMPORAL_DENOISE_THRESHOLD{(commandlineArguments["temporal-denoise-threshold"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["temporal-denoise-threshold"])), ONE), 255u) : 8};
         const uint32_t B_BACKGROUND_DETECTION{(commandlineArguments["background-detection"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["background-detection"])), ZERO), ONE): 1};
         const uint32_t B_ADAPTIVE_QUANT{(commandlineArguments["adaptive-quant"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["adaptive-quant"])), ZERO), ONE): 1};
         const uint32_t B_FRAME_CROPPING{(commandlineArguments["frame-cropping"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["frame-cropping"])), ZERO), ONE): 1};
         const uint32_t B_SCENE_CHANGE_DETECT{(commandlineArguments["scene-change-detect"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["scene-change-detect"])), ZERO), ONE): 1};
         const uint32_t I_MULTIPLE_THREADS{(commandlineArguments["threads"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["threads"])), ZERO), FOUR): 1};
 
+        const std::string SHM_OUTPUT{commandlineArguments["shm-output"]};
+        const uint32_t SHM_OUTPUT_SLOTS{(commandlineArguments["shm-output-slots"].size() != 0) ? std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["shm-output-slots"])), TWO) : 4};
+        const std::string REC{commandlineArguments["rec"]};
+        const uint64_t REC_MAX_SIZE{(commandlineArguments["rec-max-size"].size() != 0) ? static_cast<uint64_t>(std::stoul(commandlineArguments["rec-max-size"])) * 1024 * 1024 : 0};
+        const uint32_t REC_MAX_DURATION{(commandlineArguments["rec-max-duration"].size() != 0) ? static_cast<uint32_t>(std::stoul(commandlineArguments["rec-max-duration"])) : 0};
+        const bool REC_DIRECT_IO{(commandlineArguments["rec-direct-io"].size() != 0) ? (0 != std::stoi(commandlineArguments["rec-direct-io"])) : true};
+        const std::string RTP{commandlineArguments["rtp"]};
+        const uint32_t RTP_MTU{(commandlineArguments["rtp-mtu"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["rtp-mtu"])), 128u), 65507u) : 1400};
+        const uint32_t RTP_PACKETIZATION_MODE{(commandlineArguments["rtp-packetization-mode"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["rtp-packetization-mode"])), ZERO), ONE) : 1};
+        const uint32_t RTP_PAYLOAD_TYPE{(commandlineArguments["rtp-payload-type"].size() != 0) ? std::min(std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["rtp-payload-type"])), 96u), 127u) : 96};
+        const std::string RTP_SDP{commandlineArguments["rtp-sdp"]};
+        const uint64_t RTP_PACING_RATE{(commandlineArguments["rtp-pacing-rate"].size() != 0) ? static_cast<uint64_t>(std::stoull(commandlineArguments["rtp-pacing-rate"])) : 0};
+        const uint32_t RTP_PACING_BURST{(commandlineArguments["rtp-pacing-burst"].size() != 0) ? std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["rtp-pacing-burst"])), RTP_MTU) : 4 * RTP_MTU};
+        const uint32_t RTP_FEC{(commandlineArguments["rtp-fec"].size() != 0) ? std::min(static_cast<uint32_t>(std::stoi(commandlineArguments["rtp-fec"])), 100u) : 0};
+        // Parity packets carry a header in addition to the longest RTP packet of their group.
+        const uint32_t RTP_PACKET_SIZE{RTP_MTU - ((0 < RTP_FEC) ? static_cast<uint32_t>(RTPFECEncoder::HEADER_SIZE) : 0)};
+        const bool RTP_PACING_KERNEL{(commandlineArguments["rtp-pacing-kernel"].size() != 0) ? (0 != std::stoi(commandlineArguments["rtp-pacing-kernel"])) : false};
+        const std::string RTP_ADDRESS{RTP.substr(0, RTP.find(':'))};
+        const uint16_t RTP_PORT{static_cast<uint16_t>((std::string::npos != RTP.find(':')) ? std::stoi(RTP.substr(RTP.find(':') + 1)) : 0)};
+        if (!RTP.empty() && (0 == RTP_PORT)) {
+            std::cerr << argv[0] << ": Invalid RTP destination '" << RTP << "'; expected <ip:port>." << std::endl;
+            return retCode;
+        }
+        const uint16_t TCP_PORT{static_cast<uint16_t>((commandlineArguments["tcp-port"].size() != 0) ? std::stoi(commandlineArguments["tcp-port"]) : 0)};
+        const uint32_t TCP_QUEUE{(commandlineArguments["tcp-queue"].size() != 0) ? std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["tcp-queue"])), ONE) : 10};
+        const uint32_t KEYFRAME_REQUEST_INTERVAL{(commandlineArguments["keyframe-request-interval"].size() != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["keyframe-request-interval"])) : 0};
+        const bool LTR_FEEDBACK{commandlineArguments.count("ltr-feedback") != 0};
+        const std::size_t KEYFRAME_CACHE{(commandlineArguments["keyframe-cache"].size() != 0) ? static_cast<std::size_t>(std::stoul(commandlineArguments["keyframe-cache"])) * 1024 * 1024 : 0};
+        const uint32_t FRAME_SIZE_STATS{(commandlineArguments["frame-size-stats"].size() != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["frame-size-stats"])) : 0};
+        const float STATIC_SCENE_THRESHOLD{(commandlineArguments["static-scene-threshold"].size() != 0) ? std::max(std::stof(commandlineArguments["static-scene-threshold"]), 0.0f) : 0.0f};
+        const uint32_t STATIC_SCENE_KEEPALIVE{(commandlineArguments["static-scene-keepalive"].size() != 0) ? std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["static-scene-keepalive"])), ONE) : 20};
+        const uint32_t BITRATE_BUDGET{(commandlineArguments["bitrate-budget"].size() != 0) ? static_cast<uint32_t>(std::stoul(commandlineArguments["bitrate-budget"])) : 0};
+        const std::string BITRATE_GROUP{(commandlineArguments["bitrate-group"].size() != 0) ? commandlineArguments["bitrate-group"] : "cid-" + commandlineArguments["cid"]};
+        const float BITRATE_PRIORITY{(commandlineArguments["bitrate-priority"].size() != 0) ? std::max(std::stof(commandlineArguments["bitrate-priority"]), 0.0f) : 1.0f};
+        const uint32_t QUALITY_MONITOR{(commandlineArguments["quality-monitor"].size() != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["quality-monitor"])) : 0};
+        const uint32_t QUALITY_WINDOW{(commandlineArguments["quality-window"].size() != 0) ? std::max(static_cast<uint32_t>(std::stoi(commandlineArguments["quality-window"])), ONE) : 10};
+        const bool FRAME_METADATA{commandlineArguments.count("frame-metadata") != 0};
+        const uint32_t ENCODER_STATS{(commandlineArguments["encoder-stats"].size() != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["encoder-stats"])) : 0};
+        const bool HUGE_PAGES{(commandlineArguments["huge-pages"].size() != 0) ? (0 != std::stoi(commandlineArguments["huge-pages"])) : false};
+
+        const std::vector<uint32_t> CPU_AFFINITY{parseCpuList(commandlineArguments["cpu-affinity"])};
+        const std::vector<uint32_t> ENCODER_CPU_AFFINITY{(commandlineArguments["encoder-cpu-affinity"].size() != 0) ? parseCpuList(commandlineArguments["encoder-cpu-affinity"]) : CPU_AFFINITY};
+        const int32_t RT_PRIORITY{(commandlineArguments["rt-priority"].size() != 0) ? std::min(std::max(std::stoi(commandlineArguments["rt-priority"]), 1), 99) : 0};
+        if ( (commandlineArguments["cpu-affinity"].size() != 0) && CPU_AFFINITY.empty() ) {
+            std::cerr << argv[0] << ": Invalid CPU list '" << commandlineArguments["cpu-affinity"] << "'." << std::endl;
+            return retCode;
+        }
+        if ( (commandlineArguments["encoder-cpu-affinity"].size() != 0) && ENCODER_CPU_AFFINITY.empty() ) {
+            std::cerr << argv[0] << ": Invalid CPU list '" << commandlineArguments["encoder-cpu-affinity"] << "'." << std::endl;
+            return retCode;
+        }
+
         std::unique_ptr<cluon::SharedMemory> sharedMemory(new cluon::SharedMemory{NAME});
         if (sharedMemory && sharedMemory->valid()) {
             std::clog << argv[0] << ": Attached to '" << sharedMemory->name() << "' (" << sharedMemory->size() << " bytes)." << std::endl;
 
+            // Interface to a running OpenDaVINCI session; it does not join the multicast
+            // group unless a data-triggered delegate is registered, and it is created
+            // first so that a receiving thread would be neither pinned nor real-time.
+            OD4Publisher od4{static_cast<uint16_t>(std::stoi(commandlineArguments["cid"]))};
+
+            // Requests are coalesced into one flag that is consumed by the encoding loop.
+            std::atomic<bool> keyFrameRequested{false};
+            if (0 < KEYFRAME_REQUEST_INTERVAL) {
+                od4.dataTrigger(opendlv::video::KeyFrameRequest::ID(), [&keyFrameRequested, argv, ID, VERBOSE](cluon::data::Envelope &&envelope) {
+                    if (ID == envelope.senderStamp()) {
+                        keyFrameRequested.store(true);
+                        if (VERBOSE) {
+                            auto request = cluon::extractMessage<opendlv::video::KeyFrameRequest>(std::move(envelope));
+                            std::clog << argv[0] << ": Key frame requested (" << request.reason() << ")." << std::endl;
+                        }
+                    }
+                });
+            }
+            // Feedback arrives on the receiving thread but must be passed to openh264 from the encoding thread.
+            std::mutex ltrFeedbackMutex;
+            std::vector<SLTRRecoverRequest> ltrRecoveryRequests;
+            std::vector<SLTRMarkingFeedback> ltrMarkingFeedback;
+            if (LTR_FEEDBACK) {
+                od4.dataTrigger(opendlv::video::LTRRecoveryRequest::ID(), [&ltrFeedbackMutex, &ltrRecoveryRequests, ID](cluon::data::Envelope &&envelope) {
+                    if (ID == envelope.senderStamp()) {
+                        auto request = cluon::extractMessage<opendlv::video::LTRRecoveryRequest>(std::move(envelope));
+                        SLTRRecoverRequest recoveryRequest;
+                        memset(&recoveryRequest, 0, sizeof(SLTRRecoverRequest));
+                        recoveryRequest.uiFeedbackType = (0 > request.lastCorrectFrameNumber()) ? IDR_RECOVERY_REQUEST : LTR_RECOVERY_REQUEST;
+                        recoveryRequest.uiIDRPicId = request.idrPictureId();
+                        recoveryRequest.iLastCorrectFrameNum = request.lastCorrectFrameNumber();
+                        recoveryRequest.iCurrentFrameNum = request.currentFrameNumber();
+                        std::lock_guard<std::mutex> lck(ltrFeedbackMutex);
+                        ltrRecoveryRequests.push_back(recoveryRequest);
+                    }
+                });
+                od4.dataTrigger(opendlv::video::LTRMarkingFeedback::ID(), [&ltrFeedbackMutex, &ltrMarkingFeedback, ID](cluon::data::Envelope &&envelope) {
+                    if (ID == envelope.senderStamp()) {
+                        auto feedback = cluon::extractMessage<opendlv::video::LTRMarkingFeedback>(std::move(envelope));
+                        SLTRMarkingFeedback markingFeedback;
+                        memset(&markingFeedback, 0, sizeof(SLTRMarkingFeedback));
+                        markingFeedback.uiFeedbackType = feedback.success() ? LTR_MARKING_SUCCESS : LTR_MARKING_FAILED;
+                        markingFeedback.uiIDRPicId = feedback.idrPictureId();
+                        markingFeedback.iLTRFrameNum = feedback.ltrFrameNumber();
+                        std::lock_guard<std::mutex> lck(ltrFeedbackMutex);
+                        ltrMarkingFeedback.push_back(markingFeedback);
+                    }
+                });
+            }
+            std::vector<SLTRRecoverRequest> pendingLTRRecoveryRequests;
+            std::vector<SLTRMarkingFeedback> pendingLTRMarkingFeedback;
+
+            std::atomic<bool> keyFrameCacheRequested{false};
+            if (0 < KEYFRAME_CACHE) {
+                od4.dataTrigger(opendlv::video::KeyFrameCacheRequest::ID(), [&keyFrameCacheRequested, ID](cluon::data::Envelope &&envelope) {
+                    if (ID == envelope.senderStamp()) {
+                        keyFrameCacheRequested.store(true);
+                    }
+                });
+            }
+
+            // All buffers below are pre-faulted by this thread; prefer the NUMA node of the CPUs it is pinned to
+            // later before allocating any of them. Threads created afterwards inherit this memory policy.
+            if (!CPU_AFFINITY.empty()) {
+                const int32_t NUMA_NODE{numaNodeOfCpu(CPU_AFFINITY.front())};
+                if ( (-1 < NUMA_NODE) && preferNumaNode(NUMA_NODE) && VERBOSE) {
+                    std::clog << argv[0] << ": Allocating buffers on NUMA node " << NUMA_NODE << "." << std::endl;
+                }
+            }
+
+            // Like the receiving thread, the recorder's writer thread is created before pinning the main thread.
+            std::unique_ptr<Recorder> recorder{nullptr};
+            if (!REC.empty()) {
+                recorder.reset(new Recorder{REC, REC_MAX_SIZE, std::chrono::seconds(REC_MAX_DURATION), REC_DIRECT_IO});
+                if (!recorder->isRunning()) {
+                    std::cerr << argv[0] << ": Failed to open '" << REC << "' or to allocate buffers for recording." << std::endl;
+                    return retCode;
+                }
+                std::clog << argv[0] << ": Recording h264 frames to '" << REC << "'." << std::endl;
+            }
+
+            // The accepting thread spawns the clients' sender threads; hence, it is created before pinning as well.
+            std::unique_ptr<TCPStreamServer> tcpStreamServer{nullptr};
+            if (0 < TCP_PORT) {
+                tcpStreamServer.reset(new TCPStreamServer{TCP_PORT, TCP_QUEUE, WIDTH * HEIGHT});
+                if (!tcpStreamServer->isRunning()) {
+                    std::cerr << argv[0] << ": Failed to listen on TCP port " << TCP_PORT << "." << std::endl;
+                    return retCode;
+                }
+                std::clog << argv[0] << ": Streaming h264 frames to TCP clients on port " << TCP_PORT << "." << std::endl;
+            }
+
+            // The heartbeat thread keeps the slot in the bitrate group; it must neither be pinned nor run in real-time.
+            std::unique_ptr<BitrateArbiter> bitrateArbiter{nullptr};
+            if (0 < BITRATE_BUDGET) {
+                bitrateArbiter.reset(new BitrateArbiter{BITRATE_GROUP, ID, BITRATE_PRIORITY, BITRATE_BUDGET, BITRATE_MIN, I_BITRATE_MAX});
+                if (!bitrateArbiter->valid()) {
+                    std::cerr << argv[0] << ": Failed to join bitrate group '" << bitrateArbiter->name() << "'." << std::endl;
+                    return retCode;
+                }
+                std::clog << argv[0] << ": Sharing " << BITRATE_BUDGET << " bps with bitrate group '" << bitrateArbiter->name() << "'." << std::endl;
+            }
+
+            // Decoding for quality monitoring must neither compete with the pinned threads nor run in real-time.
+            // The summaries are serialized on the monitor's thread; hence, it has a serializer of its own.
+            VideoMessageSerializer qualitySerializer{ID};
+            std::unique_ptr<QualityMonitor> qualityMonitor{nullptr};
+            if (0 < QUALITY_MONITOR) {
+                qualityMonitor.reset(new QualityMonitor{WIDTH, HEIGHT, WIDTH * HEIGHT, QUALITY_MONITOR, QUALITY_WINDOW, [&od4, &qualitySerializer, argv, VERBOSE](const QualityMonitor::Summary &summary) {
+                    opendlv::video::QualityReading qualityReading;
+                    qualityReading.samples(summary.m_samples)
+                                  .meanPsnrY(summary.m_meanPSNRY)
+                                  .minPsnrY(summary.m_minPSNRY)
+                                  .meanPsnrYuv(summary.m_meanPSNR)
+                                  .meanSsimY(summary.m_meanSSIMY)
+                                  .minSsimY(summary.m_minSSIMY)
+                                  .droppedFrames(summary.m_droppedFrames);
+                    od4.send(std::move(qualitySerializer.serialize(qualityReading, summary.m_sampleTimeStamp, cluon::time::now())));
+                    if (VERBOSE) {
+                        std::clog << argv[0] << ": Quality (" << summary.m_samples << " frames): PSNR Y = " << summary.m_meanPSNRY << " dB (min " << summary.m_minPSNRY << " dB), PSNR YUV = " << summary.m_meanPSNR << " dB, SSIM Y = " << summary.m_meanSSIMY << " (min " << summary.m_minSSIMY << ")." << std::endl;
+                    }
+                }, HUGE_PAGES});
+                if (!qualityMonitor->isRunning()) {
+                    std::cerr << argv[0] << ": Failed to create openh264 decoder for quality monitoring." << std::endl;
+                    return retCode;
+                }
+                std::clog << argv[0] << ": Monitoring quality of every " << QUALITY_MONITOR << ". frame." << std::endl;
+            }
+
+            // The pacing thread sends RTP packets on its own and is thus not pinned either.
+            std::unique_ptr<DatagramSender> rtpSender{nullptr};
+            std::unique_ptr<Pacer> rtpPacer{nullptr};
+            std::unique_ptr<DatagramSender> fecSender{nullptr};
+            if (!RTP.empty()) {
+                rtpSender.reset(new DatagramSender{RTP_ADDRESS, RTP_PORT, RTP_MTU});
+                if (!rtpSender->valid()) {
+                    std::cerr << argv[0] << ": Failed to create socket for RTP to " << RTP << "." << std::endl;
+                    return retCode;
+                }
+                if (0 < RTP_FEC) {
+                    fecSender.reset(new DatagramSender{RTP_ADDRESS, static_cast<uint16_t>(RTP_PORT + 2), RTP_MTU});
+                    if (!fecSender->valid()) {
+                        std::cerr << argv[0] << ": Failed to create socket for parity packets to " << RTP_ADDRESS << ":" << RTP_PORT + 2 << "." << std::endl;
+                        return retCode;
+                    }
+                }
+                if ( (0 < RTP_PACING_RATE) && RTP_PACING_KERNEL ) {
+                    if (!rtpSender->setMaximumPacingRate(RTP_PACING_RATE)) {
+                        std::cerr << argv[0] << ": Warning, failed to set SO_MAX_PACING_RATE: " << strerror(errno) << std::endl;
+                    }
+                    // The parity packets are paced on their own socket in proportion to their share.
+                    if (fecSender && !fecSender->setMaximumPacingRate(std::max<uint64_t>(RTP_PACING_RATE * RTP_FEC / 100, 8 * RTP_MTU))) {
+                        std::cerr << argv[0] << ": Warning, failed to set SO_MAX_PACING_RATE for parity packets: " << strerror(errno) << std::endl;
+                    }
+                }
+                else if (0 < RTP_PACING_RATE) {
+                    // Queue at least one frame of the maximum size together with its parity packets.
+                    const uint32_t QUEUED_PACKETS{std::max((WIDTH * HEIGHT / RTP_MTU + 1) * (100 + RTP_FEC) / 100 + 1, 64u)};
+                    rtpPacer.reset(new Pacer{*rtpSender, RTP_PACING_RATE, RTP_PACING_BURST, RTP_MTU, QUEUED_PACKETS});
+                    if (!rtpPacer->isRunning()) {
+                        std::cerr << argv[0] << ": Failed to allocate buffers for pacing RTP packets." << std::endl;
+                        return retCode;
+                    }
+                }
+            }
+
+            // openh264 spawns its worker threads in InitializeExt; they inherit
+            // affinity and scheduling policy from the calling thread.
+            if (!ENCODER_CPU_AFFINITY.empty()) {
+                const int32_t AFFINITY_ERROR{pinCurrentThread(ENCODER_CPU_AFFINITY)};
+                if (0 != AFFINITY_ERROR) {
+                    std::cerr << argv[0] << ": Warning, failed to set CPU affinity for encoder threads: " << strerror(AFFINITY_ERROR) << std::endl;
+                }
+            }
+            if ( (0 < RT_PRIORITY) && !setRealtimePriority(RT_PRIORITY) ) {
+                std::cerr << argv[0] << ": Warning, failed to set SCHED_FIFO priority " << RT_PRIORITY << " (missing CAP_SYS_NICE?)." << std::endl;
+            }
+
             ISVCEncoder *encoder{nullptr};
             if (0 != WelsCreateSVCEncoder(&encoder) || (nullptr == encoder)) {
                 std::cerr << argv[0] << ": Failed to create openh264 encoder." << std::endl;
@@ -129,7 +438,7 @@ int32_t main(int32_t argc, char **argv) {
                 memset(&parameters, 0, sizeof(SEncParamBase));
                 encoder->GetDefaultParams(&parameters);
 
-                parameters.fMaxFrameRate = 20 /*FPS*/; // This parameter is implicitly given by the notifications from the shared memory.
+                parameters.fMaxFrameRate = (0.0f < TARGET_FPS) ? TARGET_FPS : 20 /*FPS*/; // Otherwise, this parameter is implicitly given by the notifications from the shared memory.
                 parameters.iUsageType = EUsageType::CAMERA_VIDEO_REAL_TIME;
                 parameters.iPicWidth = WIDTH;
                 parameters.iPicHeight = HEIGHT;
@@ -147,6 +456,11 @@ int32_t main(int32_t argc, char **argv) {
                 parameters.sSpatialLayers[0].iMaxSpatialBitrate = I_BITRATE_MAX;
                 parameters.sSpatialLayers[0].sSliceArgument.uiSliceMode = SliceModeEnum::SM_SIZELIMITED_SLICE;
                 parameters.sSpatialLayers[0].sSliceArgument.uiSliceNum = 1;
+                if (!RTP.empty() && (0 == RTP_PACKETIZATION_MODE)) {
+                    // Single NAL unit mode cannot fragment; hence, every slice must fit into one RTP packet.
+                    parameters.sSpatialLayers[0].sSliceArgument.uiSliceSizeConstraint = RTP_PACKET_SIZE - RTPPacketizer::RTP_HEADER_SIZE;
+                    parameters.uiMaxNalSize = RTP_PACKET_SIZE - RTPPacketizer::RTP_HEADER_SIZE;
+                }
 
                 /*
                  * Thesis parameters
@@ -167,7 +481,11 @@ int32_t main(int32_t argc, char **argv) {
                 parameters.iMaxBitrate = I_BITRATE_MAX;
                 parameters.iMaxQp = I_MAX_QP;
                 parameters.iMinQp = I_MIN_QP;
-                parameters.bEnableLongTermReference = B_LONG_TERM_REFERENCE;
+                parameters.bEnableLongTermReference = B_LONG_TERM_REFERENCE || LTR_FEEDBACK;
+                if (LTR_FEEDBACK) {
+                    // Only frames acknowledged by consumers are used as long-term references.
+                    parameters.bIsLosslessLink = false;
+                }
                 parameters.iLoopFilterDisableIdc = I_LOOP_FILTER;
                 parameters.bEnableDenoise = B_DENOISE;
                 parameters.bEnableBackgroundDetection = B_BACKGROUND_DETECTION;
@@ -204,29 +522,236 @@ int32_t main(int32_t argc, char **argv) {
                 std::clog << argv[0] << ": Encoding bitrate = " << BITRATE << std::endl;
             }
 
+            const std::chrono::milliseconds BITRATE_ARBITRATION_INTERVAL{250};
+            std::chrono::steady_clock::time_point lastBitrateArbitration{std::chrono::steady_clock::now()};
+            uint64_t bytesSinceBitrateArbitration{0};
+            uint32_t currentBitrate{BITRATE};
+
+            const std::chrono::milliseconds ENCODER_STATISTICS_INTERVAL{ENCODER_STATS};
+            std::chrono::steady_clock::time_point lastEncoderStatistics{std::chrono::steady_clock::now()};
+            const std::chrono::seconds RTP_STATISTICS_INTERVAL{1};
+            std::chrono::steady_clock::time_point lastRTPStatistics{std::chrono::steady_clock::now()};
+
+            if (!CPU_AFFINITY.empty()) {
+                const int32_t AFFINITY_ERROR{pinCurrentThread(CPU_AFFINITY)};
+                if (0 != AFFINITY_ERROR) {
+                    std::cerr << argv[0] << ": Warning, failed to set CPU affinity: " << strerror(AFFINITY_ERROR) << std::endl;
+                }
+            }
+
             // Allocate image buffer to hold h264 frame as output.
-            std::vector<char> h264Buffer;
-            h264Buffer.resize(WIDTH * HEIGHT, '0'); // In practice, this is small than WIDTH * HEIGHT
+            BufferPool bitstreamPool{WIDTH * HEIGHT /* In practice, this is small than WIDTH * HEIGHT */, 1, HUGE_PAGES};
+            uint8_t *h264Buffer{bitstreamPool.acquire()};
+            if (nullptr == h264Buffer) {
+                std::cerr << argv[0] << ": Failed to allocate buffer for h264 frames." << std::endl;
+                return retCode;
+            }
+            if (VERBOSE) {
+                std::clog << argv[0] << ": Pre-faulted " << bitstreamPool.bufferSize() << " bytes for h264 frames" << (bitstreamPool.usesHugePages() ? " using huge pages." : ".") << std::endl;
+            }
 
-            cluon::data::TimeStamp before, after, sampleTimeStamp;
+            // Reused across frames so that publishing does not reallocate for every frame.
+            ImageReadingSerializer serializer{"h264", WIDTH, HEIGHT, ID, bitstreamPool.bufferSize()};
+            VideoMessageSerializer messageSerializer{ID};
+
+            std::unique_ptr<KeyFrameCache> keyFrameCache{nullptr};
+            std::unique_ptr<ImageReadingSerializer> cachedFrameSerializer{nullptr};
+            if (0 < KEYFRAME_CACHE) {
+                keyFrameCache.reset(new KeyFrameCache{KEYFRAME_CACHE, (0 < GOP) ? GOP : std::numeric_limits<uint32_t>::max()});
+                cachedFrameSerializer.reset(new ImageReadingSerializer{"h264", WIDTH, HEIGHT, ID, bitstreamPool.bufferSize(), opendlv::video::CachedImageReading::ID()});
+            }
+
+            std::unique_ptr<FrameSizeStatistics> frameSizeStatistics{nullptr};
+            if (0 < FRAME_SIZE_STATS) {
+                frameSizeStatistics.reset(new FrameSizeStatistics{FRAME_SIZE_STATS});
+            }
+
+            // Luma of the last encoded frame to detect static scenes.
+            const uint32_t STATIC_SCENE_SAD_LIMIT{static_cast<uint32_t>(STATIC_SCENE_THRESHOLD * 16 * 16)};
+            std::unique_ptr<BufferPool> lastEncodedLumaPool{nullptr};
+            uint8_t *lastEncodedLuma{nullptr};
+            if (0 < STATIC_SCENE_SAD_LIMIT) {
+                lastEncodedLumaPool.reset(new BufferPool{static_cast<std::size_t>(WIDTH * HEIGHT), 1, HUGE_PAGES});
+                lastEncodedLuma = lastEncodedLumaPool->acquire();
+                if (nullptr == lastEncodedLuma) {
+                    std::cerr << argv[0] << ": Failed to allocate buffer for static scene detection." << std::endl;
+                    return retCode;
+                }
+            }
+            bool hasLastEncodedLuma{false};
+            uint32_t unchangedFrames{0};
+
+            // Neutral chroma shared by both planes and all grayscale frames; openh264 only reads it.
+            std::unique_ptr<BufferPool> constantChromaPool{nullptr};
+            uint8_t *constantChroma{nullptr};
+            if (GRAY) {
+                constantChromaPool.reset(new BufferPool{static_cast<std::size_t>(WIDTH * HEIGHT / 4), 1, HUGE_PAGES});
+                constantChroma = constantChromaPool->acquire();
+                if (nullptr == constantChroma) {
+                    std::cerr << argv[0] << ": Failed to allocate buffer for constant chroma." << std::endl;
+                    return retCode;
+                }
+                memset(constantChroma, 128, constantChromaPool->bufferSize());
+                std::clog << argv[0] << ": Encoding grayscale frames; reading " << INPUT_FRAME_SIZE << " instead of " << INPUT_FRAME_SIZE * 3 / 2 << " bytes per frame from the shared memory." << std::endl;
+            }
 
-            // Interface to a running OpenDaVINCI session (ignoring any incoming Envelopes).
-            cluon::OD4Session od4{static_cast<uint16_t>(std::stoi(commandlineArguments["cid"]))};
+            // Remapped frame that is encoded instead of the shared memory.
+            std::unique_ptr<Remapper> remapper{nullptr};
+            std::unique_ptr<BufferPool> remappedFramePool{nullptr};
+            uint8_t *remappedFrame{nullptr};
+            if (!REMAP.empty()) {
+                remapper.reset(new Remapper{REMAP, WIDTH, HEIGHT, GRAY});
+                if (!remapper->valid()) {
+                    std::cerr << argv[0] << ": Failed to load lookup table '" << REMAP << "' for remapping." << std::endl;
+                    return retCode;
+                }
+                remappedFramePool.reset(new BufferPool{INPUT_FRAME_SIZE, 1, HUGE_PAGES});
+                remappedFrame = remappedFramePool->acquire();
+                if (nullptr == remappedFrame) {
+                    std::cerr << argv[0] << ": Failed to allocate buffer for remapping." << std::endl;
+                    return retCode;
+                }
+                std::clog << argv[0] << ": Remapping frames with '" << REMAP << "' (" << remapper->borderPixels() << " pixels outside of the source frame)." << std::endl;
+            }
+            int64_t remapDuration{0};
+
+            // Temporally filtered frame that is encoded instead of the shared memory.
+            std::unique_ptr<BufferPool> denoisedFramePool{nullptr};
+            uint8_t *denoisedFrame{nullptr};
+            if (0 < TEMPORAL_DENOISE) {
+                denoisedFramePool.reset(new BufferPool{INPUT_FRAME_SIZE, 1, HUGE_PAGES});
+                denoisedFrame = denoisedFramePool->acquire();
+                if (nullptr == denoisedFrame) {
+                    std::cerr << argv[0] << ": Failed to allocate buffer for temporal denoising." << std::endl;
+                    return retCode;
+                }
+                if (VERBOSE) {
+                    std::clog << argv[0] << ": Temporal denoising with strength " << TEMPORAL_DENOISE << "/16 below differences of " << TEMPORAL_DENOISE_THRESHOLD << "." << std::endl;
+                }
+            }
+            bool hasDenoisedFrame{false};
+            int64_t denoiseDuration{0};
+
+            std::unique_ptr<SharedMemorySink> sharedMemorySink{nullptr};
+            if (!SHM_OUTPUT.empty()) {
+                sharedMemorySink.reset(new SharedMemorySink{SHM_OUTPUT, SHM_OUTPUT_SLOTS, static_cast<uint32_t>(bitstreamPool.bufferSize()), WIDTH, HEIGHT});
+                if (!sharedMemorySink->valid()) {
+                    std::cerr << argv[0] << ": Failed to create shared memory '" << SHM_OUTPUT << "' for h264 frames." << std::endl;
+                    return retCode;
+                }
+                std::clog << argv[0] << ": Publishing h264 frames to shared memory '" << sharedMemorySink->name() << "' (" << SHM_OUTPUT_SLOTS << " slots)." << std::endl;
+            }
+
+            std::unique_ptr<RTPPacketizer> rtpPacketizer{nullptr};
+            std::unique_ptr<RTPFECEncoder> fecEncoder{nullptr};
+            std::vector<NalUnit> nalUnits;
+            // Version of the SPS and PPS that the SDP file describes.
+            uint32_t sdpParameterSetsVersion{0};
+            if (!RTP.empty()) {
+                rtpPacketizer.reset(new RTPPacketizer{RTP_PACKET_SIZE, static_cast<uint8_t>(RTP_PAYLOAD_TYPE), static_cast<uint8_t>(RTP_PACKETIZATION_MODE), static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^ ID});
+                std::clog << argv[0] << ": Sending h264 frames as RTP to " << RTP_ADDRESS << ":" << RTP_PORT << " (packetization mode " << RTP_PACKETIZATION_MODE << ")";
+                if (0 < RTP_PACING_RATE) {
+                    std::clog << " paced at " << RTP_PACING_RATE << " bps" << (RTP_PACING_KERNEL ? " by the kernel" : "");
+                }
+                std::clog << "." << std::endl;
+                if (0 < RTP_FEC) {
+                    // Groups are rounded up so that the overhead does not exceed the requested one.
+                    const uint32_t FEC_GROUP_SIZE{(100 + RTP_FEC - 1) / RTP_FEC};
+                    fecEncoder.reset(new RTPFECEncoder{FEC_GROUP_SIZE, RTP_PACKET_SIZE});
+                    std::clog << argv[0] << ": Sending one parity packet per " << FEC_GROUP_SIZE << " RTP packets to " << RTP_ADDRESS << ":" << RTP_PORT + 2 << "." << std::endl;
+                }
+            }
+
+            // Built once as every std::function capturing more than a pointer allocates.
+            const std::function<void(const uint8_t*, std::size_t)> sendParityPacket{[&fecSender, &rtpPacer](const uint8_t *parity, std::size_t parityLength){
+                // Parity packets share the pacing rate with the RTP packets they protect.
+                if (rtpPacer) {
+                    rtpPacer->send(parity, parityLength, *fecSender);
+                }
+                else {
+                    fecSender->append(parity, parityLength);
+                }
+            }};
+            const std::function<void(const uint8_t*, std::size_t)> sendRTPPacket{[&rtpSender, &rtpPacer, &fecEncoder, &sendParityPacket](const uint8_t *packet, std::size_t length){
+                if (rtpPacer) {
+                    rtpPacer->send(packet, length);
+                }
+                else {
+                    rtpSender->append(packet, length);
+                }
+                if (fecEncoder) {
+                    fecEncoder->add(packet, length, sendParityPacket);
+                }
+            }};
+
+            if (rtpPacketizer || keyFrameCache) {
+                nalUnits.reserve(MAX_LAYER_NUM_OF_FRAME * MAX_NAL_UNITS_IN_LAYER);
+            }
+
+            std::unique_ptr<FrameDecimator> frameDecimator{nullptr};
+            if (0.0f < TARGET_FPS) {
+                frameDecimator.reset(new FrameDecimator{sharedMemory->name(), TARGET_FPS});
+                std::clog << argv[0] << ": Encoding " << TARGET_FPS << " fps selected by " << (frameDecimator->hasProducerTimeStamps() ? "the producer's time stamps" : "the time of notification") << "." << std::endl;
+            }
+
+            cluon::data::TimeStamp before, after, sampleTimeStamp;
+            int64_t lastPictureTimeStamp{0};
+            int64_t pictureTimeStampOffset{0};
+            std::chrono::steady_clock::time_point lastIDR{};
+            // Without periodic IDR frames, TCP clients and key frame cache requests need one;
+            // they are not rate limited by their senders and hence, by a minimum interval here.
+            const std::chrono::milliseconds INTERNAL_KEYFRAME_REQUEST_INTERVAL{std::max(KEYFRAME_REQUEST_INTERVAL, 1000u)};
+            bool internalKeyFrameRequested{false};
 
             while ( (sharedMemory && sharedMemory->valid()) && od4.isRunning() ) {
                 // Wait for incoming frame.
                 sharedMemory->wait();
 
                 sampleTimeStamp = cluon::time::now();
+                if (frameDecimator && !frameDecimator->select(sampleTimeStamp)) {
+                    continue;
+                }
 
                 int totalSize{0};
+                int numberOfLayers{0};
+                int numberOfNalUnits{0};
+                int droppedSize{0};
+                nalUnits.clear();
+                EVideoFrameType frameType{videoFrameTypeInvalid};
+                uint8_t *qualitySourceFrame{nullptr};
                 sharedMemory->lock();
                 {
                     // Read notification timestamp.
                     auto r = sharedMemory->getTimeStamp();
                     sampleTimeStamp = (r.first ? r.second : sampleTimeStamp);
                 }
-                {
+                bool unchanged{false};
+                if ( (nullptr != lastEncodedLuma) && hasLastEncodedLuma && (unchangedFrames < STATIC_SCENE_KEEPALIVE) && !keyFrameRequested.load() && !internalKeyFrameRequested ) {
+                    // Compare against the last encoded frame and not the previous one to not miss slow changes.
+                    unchanged = (STATIC_SCENE_SAD_LIMIT >= maximumBlockSAD(reinterpret_cast<const uint8_t*>(sharedMemory->data()), lastEncodedLuma, WIDTH, HEIGHT, STATIC_SCENE_SAD_LIMIT));
+                }
+                if (!unchanged) {
+                    // The source of the encoder; the remapped or denoised frame when enabled.
+                    const uint8_t *i420{reinterpret_cast<const uint8_t*>(sharedMemory->data())};
+                    if (nullptr != remappedFrame) {
+                        const cluon::data::TimeStamp remapStart{VERBOSE ? cluon::time::now() : cluon::data::TimeStamp{}};
+                        remapper->remap(i420, remappedFrame);
+                        i420 = remappedFrame;
+                        if (VERBOSE) {
+                            remapDuration = cluon::time::deltaInMicroseconds(cluon::time::now(), remapStart);
+                        }
+                    }
+                    if (nullptr != denoisedFrame) {
+                        const cluon::data::TimeStamp denoiseStart{VERBOSE ? cluon::time::now() : cluon::data::TimeStamp{}};
+                        // The first frame initializes the filter.
+                        temporalDenoise(i420, denoisedFrame, INPUT_FRAME_SIZE, static_cast<uint8_t>(hasDenoisedFrame ? TEMPORAL_DENOISE : 0), static_cast<uint8_t>(TEMPORAL_DENOISE_THRESHOLD));
+                        hasDenoisedFrame = true;
+                        i420 = denoisedFrame;
+                        if (VERBOSE) {
+                            denoiseDuration = cluon::time::deltaInMicroseconds(cluon::time::now(), denoiseStart);
+                        }
+                    }
+
                     SFrameBSInfo frameInfo;
                     memset(&frameInfo, 0, sizeof(SFrameBSInfo));
 
@@ -239,30 +764,108 @@ int32_t main(int32_t argc, char **argv) {
                     sourceFrame.iStride[0] = WIDTH;
                     sourceFrame.iStride[1] = WIDTH/2;
                     sourceFrame.iStride[2] = WIDTH/2;
-                    sourceFrame.pData[0] = reinterpret_cast<uint8_t*>(sharedMemory->data());
-                    sourceFrame.pData[1] = reinterpret_cast<uint8_t*>(sharedMemory->data() + (WIDTH * HEIGHT));
-                    sourceFrame.pData[2] = reinterpret_cast<uint8_t*>(sharedMemory->data() + (WIDTH * HEIGHT + ((WIDTH * HEIGHT) >> 2)));
+                    sourceFrame.pData[0] = const_cast<uint8_t*>(i420);
+                    sourceFrame.pData[1] = GRAY ? constantChroma : const_cast<uint8_t*>(i420 + (WIDTH * HEIGHT));
+                    sourceFrame.pData[2] = GRAY ? constantChroma : const_cast<uint8_t*>(i420 + (WIDTH * HEIGHT + ((WIDTH * HEIGHT) >> 2)));
+                    // openh264 expects milliseconds; RC_TIMESTAMP_MODE derives the frame
+                    // interval from them, which requires strictly increasing values. When
+                    // the producer's time stamps repeat or step back, the following ones
+                    // are shifted so that their intervals are kept.
+                    int64_t pictureTimeStamp{cluon::time::toMicroseconds(sampleTimeStamp) / 1000 + pictureTimeStampOffset};
+                    if (pictureTimeStamp <= lastPictureTimeStamp) {
+                        pictureTimeStampOffset += lastPictureTimeStamp + 1 - pictureTimeStamp;
+                        pictureTimeStamp = lastPictureTimeStamp + 1;
+                    }
+                    lastPictureTimeStamp = pictureTimeStamp;
+                    sourceFrame.uiTimeStamp = pictureTimeStamp;
 
-                    if (VERBOSE) {
+                    if (LTR_FEEDBACK) {
+                        {
+                            std::lock_guard<std::mutex> lck(ltrFeedbackMutex);
+                            pendingLTRRecoveryRequests.swap(ltrRecoveryRequests);
+                            pendingLTRMarkingFeedback.swap(ltrMarkingFeedback);
+                        }
+                        for (auto &markingFeedback : pendingLTRMarkingFeedback) {
+                            encoder->SetOption(ENCODER_LTR_MARKING_FEEDBACK, &markingFeedback);
+                        }
+                        for (auto &recoveryRequest : pendingLTRRecoveryRequests) {
+                            // openh264 falls back to an IDR frame when no acknowledged long-term reference frame is available.
+                            encoder->SetOption(ENCODER_LTR_RECOVERY_REQUEST, &recoveryRequest);
+                            if (VERBOSE) {
+                                std::clog << argv[0] << ": " << ((IDR_RECOVERY_REQUEST == recoveryRequest.uiFeedbackType) ? "IDR" : "LTR") << " recovery requested (last correct frame_num " << recoveryRequest.iLastCorrectFrameNum << ", current frame_num " << recoveryRequest.iCurrentFrameNum << ")." << std::endl;
+                            }
+                        }
+                        pendingLTRMarkingFeedback.clear();
+                        pendingLTRRecoveryRequests.clear();
+                    }
+
+                    if ( (keyFrameRequested.load() && (std::chrono::milliseconds(KEYFRAME_REQUEST_INTERVAL) <= std::chrono::steady_clock::now() - lastIDR)) ||
+                         (internalKeyFrameRequested && (INTERNAL_KEYFRAME_REQUEST_INTERVAL <= std::chrono::steady_clock::now() - lastIDR)) ) {
+                        encoder->ForceIntraFrame(true);
+                    }
+
+                    if (VERBOSE || FRAME_METADATA) {
                         before = cluon::time::now();
                     }
                     auto result = encoder->EncodeFrame(&sourceFrame, &frameInfo);
-                    if (VERBOSE) {
+                    if (VERBOSE || FRAME_METADATA) {
                         after = cluon::time::now();
                     }
                     if (cmResultSuccess == result) {
+                        frameType = frameInfo.eFrameType;
+                        if ( (nullptr != lastEncodedLuma) && (videoFrameTypeSkip != frameType) ) {
+                            memcpy(lastEncodedLuma, sharedMemory->data(), WIDTH * HEIGHT);
+                            hasLastEncodedLuma = true;
+                        }
+                        if (videoFrameTypeIDR == frameType) {
+                            // Any IDR frame, forced or regular, satisfies pending requests.
+                            lastIDR = std::chrono::steady_clock::now();
+                            keyFrameRequested.store(false);
+                            internalKeyFrameRequested = false;
+                        }
                         if (videoFrameTypeSkip == frameInfo.eFrameType) {
                             std::cerr << argv[0] << ": Warning, skipping frame." << std::endl;
                         }
                         else {
+                            numberOfLayers = frameInfo.iLayerNum;
                             for(int layer{0}; layer < frameInfo.iLayerNum; layer++) {
                                 int sizeOfLayer{0};
                                 for(int nal{0}; nal < frameInfo.sLayerInfo[layer].iNalCount; nal++) {
                                     sizeOfLayer += frameInfo.sLayerInfo[layer].pNalLengthInByte[nal];
                                 }
-                                memcpy(&h264Buffer[totalSize], frameInfo.sLayerInfo[layer].pBsBuf, sizeOfLayer);
+                                numberOfNalUnits += frameInfo.sLayerInfo[layer].iNalCount;
+                                if (bitstreamPool.bufferSize() < static_cast<std::size_t>(totalSize + sizeOfLayer)) {
+                                    std::cerr << argv[0] << ": Warning, h264 frame exceeds " << bitstreamPool.bufferSize() << " bytes; dropping frame." << std::endl;
+                                    // The frame's metadata still describes the complete access unit.
+                                    for (int remainingLayer{layer + 1}; remainingLayer < frameInfo.iLayerNum; remainingLayer++) {
+                                        numberOfNalUnits += frameInfo.sLayerInfo[remainingLayer].iNalCount;
+                                    }
+                                    droppedSize = frameInfo.iFrameSizeInBytes;
+                                    totalSize = 0;
+                                    nalUnits.clear();
+                                    break;
+                                }
+                                memcpy(h264Buffer + totalSize, frameInfo.sLayerInfo[layer].pBsBuf, sizeOfLayer);
+                                if (rtpPacketizer || keyFrameCache) {
+                                    // NAL units refer to h264Buffer as openh264 reuses its own buffers with the next frame.
+                                    int offset{totalSize};
+                                    for(int nal{0}; nal < frameInfo.sLayerInfo[layer].iNalCount; nal++) {
+                                        nalUnits.push_back(NalUnit::fromAnnexB(h264Buffer + offset, frameInfo.sLayerInfo[layer].pNalLengthInByte[nal]));
+                                        offset += frameInfo.sLayerInfo[layer].pNalLengthInByte[nal];
+                                    }
+                                }
                                 totalSize += sizeOfLayer;
                             }
+                            if (qualityMonitor && (0 < totalSize)) {
+                                // The source frame is only available while the shared memory is locked.
+                                qualitySourceFrame = qualityMonitor->acquireSourceFrame();
+                                if (nullptr != qualitySourceFrame) {
+                                    memcpy(qualitySourceFrame, i420, INPUT_FRAME_SIZE);
+                                    if (GRAY) {
+                                        memset(qualitySourceFrame + WIDTH * HEIGHT, 128, WIDTH * HEIGHT / 2);
+                                    }
+                                }
+                            }
                         }
                     }
                     else {
@@ -271,14 +874,198 @@ int32_t main(int32_t argc, char **argv) {
                 }
                 sharedMemory->unlock();
 
+                if (unchanged) {
+                    unchangedFrames++;
+                    opendlv::video::UnchangedFrame unchangedFrame;
+                    unchangedFrame.skippedFrames(unchangedFrames);
+                    od4.send(std::move(messageSerializer.serialize(unchangedFrame, sampleTimeStamp, cluon::time::now())));
+                }
+                else {
+                    unchangedFrames = 0;
+                }
+
+                if (FRAME_METADATA && (unchanged || (videoFrameTypeInvalid != frameType))) {
+                    opendlv::video::FrameMetadata frameMetadata;
+                    frameMetadata.frameType(static_cast<uint32_t>(unchanged ? videoFrameTypeSkip : frameType))
+                                 .skipReason(unchanged ? 2 : ((videoFrameTypeSkip == frameType) ? 1 : ((0 < droppedSize) ? 3 : 0)))
+                                 .layers(static_cast<uint32_t>(numberOfLayers))
+                                 .nalUnits(static_cast<uint32_t>(numberOfNalUnits))
+                                 .size(static_cast<uint32_t>((0 < droppedSize) ? droppedSize : totalSize));
+                    if (!unchanged) {
+                        // The statistics hold the average QP of the most recently encoded frame.
+                        SEncoderStatistics statistics;
+                        memset(&statistics, 0, sizeof(SEncoderStatistics));
+                        encoder->GetOption(ENCODER_OPTION_GET_STATISTICS, &statistics);
+                        frameMetadata.averageQp(statistics.uiAverageFrameQP)
+                                     .queueLatency(static_cast<uint32_t>(std::max<int64_t>(cluon::time::deltaInMicroseconds(before, sampleTimeStamp), 0)))
+                                     .encodeDuration(static_cast<uint32_t>(std::max<int64_t>(cluon::time::deltaInMicroseconds(after, before), 0)));
+                    }
+                    std::string &envelope = messageSerializer.serialize(frameMetadata, sampleTimeStamp, cluon::time::now());
+                    auto sent = od4.send(std::move(envelope));
+                    if (0 > sent.first) {
+                        std::cerr << argv[0] << ": Failed to send frame metadata: " << strerror(sent.second) << std::endl;
+                    }
+                }
+
                 if (0 < totalSize) {
-                    opendlv::proxy::ImageReading ir;
-                    ir.fourcc("h264").width(WIDTH).height(HEIGHT).data(std::string(&h264Buffer[0], totalSize));
-                    od4.send(ir, sampleTimeStamp, ID);
+                    std::string &envelope = serializer.serialize(h264Buffer, totalSize, sampleTimeStamp, cluon::time::now());
+                    // OD4Publisher::send only reads from the given string; hence, the buffer remains owned by serializer.
+                    auto sent = od4.send(std::move(envelope));
+                    if (0 > sent.first) {
+                        std::cerr << argv[0] << ": Failed to send h264 frame of " << envelope.size() << " bytes: " << strerror(sent.second) << std::endl;
+                    }
+                    if (recorder && !recorder->append(envelope)) {
+                        std::cerr << argv[0] << ": Warning, recorder is behind; dropped " << recorder->droppedEnvelopes() << " frames so far." << std::endl;
+                    }
+                    if (sharedMemorySink && !sharedMemorySink->write(h264Buffer, static_cast<uint32_t>(totalSize), sampleTimeStamp, static_cast<uint32_t>(frameType))) {
+                        std::cerr << argv[0] << ": Failed to write h264 frame to shared memory '" << sharedMemorySink->name() << "'." << std::endl;
+                    }
+
+                    if (tcpStreamServer) {
+                        tcpStreamServer->publish(h264Buffer, static_cast<std::size_t>(totalSize), videoFrameTypeIDR == frameType, keyFrameCache.get());
+                    }
+                    if (keyFrameCache) {
+                        keyFrameCache->update(h264Buffer, static_cast<std::size_t>(totalSize), nalUnits.data(), nalUnits.size(), videoFrameTypeIDR == frameType, sampleTimeStamp);
+                        // A request is kept until the cache is complete again, i.e., until the next IDR frame.
+                        if (keyFrameCache->isComplete() && keyFrameCacheRequested.exchange(false)) {
+                            for (auto &f : keyFrameCache->frames()) {
+                                std::string &cachedFrame = cachedFrameSerializer->serialize(reinterpret_cast<const uint8_t*>(f.m_data->data()), f.m_data->size(), f.m_sampleTimeStamp, cluon::time::now());
+                                auto sentCached = od4.send(std::move(cachedFrame));
+                                if (0 > sentCached.first) {
+                                    std::cerr << argv[0] << ": Failed to send cached h264 frame of " << cachedFrame.size() << " bytes: " << strerror(sentCached.second) << std::endl;
+                                }
+                            }
+                            if (VERBOSE) {
+                                std::clog << argv[0] << ": Sent " << keyFrameCache->frames().size() << " cached frames." << std::endl;
+                            }
+                        }
+                    }
+                    // With --gop=0, the next IDR frame would never come for a TCP client that fell
+                    // behind or for a request while the cache is incomplete.
+                    if ( (0 == GOP) && ( (tcpStreamServer && tcpStreamServer->waitsForIDR()) || (keyFrameCache && !keyFrameCache->isComplete() && keyFrameCacheRequested.load()) ) ) {
+                        internalKeyFrameRequested = true;
+                    }
+                    if (rtpPacketizer) {
+                        const uint32_t DROPPED{rtpPacketizer->packetize(nalUnits.data(), nalUnits.size(), RTPPacketizer::toRTPTimeStamp(cluon::time::toMicroseconds(sampleTimeStamp)), sendRTPPacket)};
+                        if (!rtpPacer) {
+                            // All packets of an access unit are sent at once.
+                            rtpSender->flush();
+                        }
+                        if (fecEncoder) {
+                            // Groups end with the access unit so that receivers need not wait for the next one.
+                            fecEncoder->finish(sendParityPacket);
+                            if (!rtpPacer) {
+                                fecSender->flush();
+                            }
+                        }
+                        if (0 < DROPPED) {
+                            std::cerr << argv[0] << ": Warning, dropped " << DROPPED << " NAL units exceeding --rtp-mtu in packetization mode 0." << std::endl;
+                        }
+                        if ( !RTP_SDP.empty() && (sdpParameterSetsVersion != rtpPacketizer->parameterSetsVersion())
+                          && !rtpPacketizer->sps().empty() && !rtpPacketizer->pps().empty() ) {
+                            // The SDP file carries SPS and PPS; it is replaced atomically
+                            // whenever they change so that players never read a partial file.
+                            sdpParameterSetsVersion = rtpPacketizer->parameterSetsVersion();
+                            const std::string TEMPORARY_SDP{RTP_SDP + ".tmp"};
+                            bool sdpWritten{false};
+                            {
+                                std::ofstream sdpFile(TEMPORARY_SDP, std::ios::out | std::ios::trunc);
+                                sdpFile << rtpPacketizer->sdp(RTP_ADDRESS, RTP_PORT);
+                                sdpFile.close();
+                                sdpWritten = sdpFile.good() && (0 == std::rename(TEMPORARY_SDP.c_str(), RTP_SDP.c_str()));
+                            }
+                            if (!sdpWritten) {
+                                std::cerr << argv[0] << ": Failed to write SDP file '" << RTP_SDP << "'." << std::endl;
+                            }
+                            else if (VERBOSE) {
+                                std::clog << argv[0] << ": Wrote SDP file '" << RTP_SDP << "' for new SPS/PPS." << std::endl;
+                            }
+                        }
+                    }
+
+                    if (qualityMonitor) {
+                        qualityMonitor->submit(h264Buffer, static_cast<std::size_t>(totalSize), videoFrameTypeIDR == frameType, qualitySourceFrame, sampleTimeStamp);
+                    }
+
+                    if (frameSizeStatistics && frameSizeStatistics->record(static_cast<uint32_t>(totalSize), videoFrameTypeIDR == frameType)) {
+                        std::clog << argv[0] << ": Frame sizes (" << FRAME_SIZE_STATS << " frames): " << frameSizeStatistics->toString() << std::endl;
+                    }
 
                     if (VERBOSE) {
-                        std::clog << argv[0] << ": Frame size = " << totalSize << " bytes; sample time = " << cluon::time::toMicroseconds(sampleTimeStamp) << " microseconds; encoding took " << cluon::time::deltaInMicroseconds(after, before) << " microseconds." << std::endl;
+                        std::clog << argv[0] << ": Frame size = " << totalSize << " bytes; sample time = " << cluon::time::toMicroseconds(sampleTimeStamp) << " microseconds; encoding took " << cluon::time::deltaInMicroseconds(after, before) << " microseconds";
+                        if (nullptr != remappedFrame) {
+                            std::clog << "; remapping took " << remapDuration << " microseconds";
+                        }
+                        if (nullptr != denoisedFrame) {
+                            std::clog << "; denoising took " << denoiseDuration << " microseconds";
+                        }
+                        std::clog << "." << std::endl;
+                    }
+                }
+
+                if (bitrateArbiter) {
+                    bytesSinceBitrateArbitration += static_cast<uint64_t>(totalSize);
+                    const auto NOW{std::chrono::steady_clock::now()};
+                    if (BITRATE_ARBITRATION_INTERVAL <= NOW - lastBitrateArbitration) {
+                        SEncoderStatistics statistics;
+                        memset(&statistics, 0, sizeof(SEncoderStatistics));
+                        encoder->GetOption(ENCODER_OPTION_GET_STATISTICS, &statistics);
+
+                        const double BITS_PER_SECOND{static_cast<double>(bytesSinceBitrateArbitration * 8) / std::chrono::duration<double>(NOW - lastBitrateArbitration).count()};
+                        const uint32_t NEW_BITRATE{bitrateArbiter->update(BitrateArbiter::complexity(BITS_PER_SECOND, statistics.uiAverageFrameQP))};
+                        // Ignore small changes to not disturb the encoder's rate control.
+                        if (currentBitrate / 20 < static_cast<uint32_t>(std::abs(static_cast<int64_t>(NEW_BITRATE) - static_cast<int64_t>(currentBitrate)))) {
+                            SBitrateInfo bitrateInfo;
+                            bitrateInfo.iLayer = SPATIAL_LAYER_ALL;
+                            bitrateInfo.iBitrate = static_cast<int>(NEW_BITRATE);
+                            if (cmResultSuccess == encoder->SetOption(ENCODER_OPTION_BITRATE, &bitrateInfo)) {
+                                currentBitrate = NEW_BITRATE;
+                                if (VERBOSE) {
+                                    std::clog << argv[0] << ": Encoding bitrate = " << currentBitrate << " (produced " << static_cast<uint32_t>(BITS_PER_SECOND) << " bps at QP " << statistics.uiAverageFrameQP << ")." << std::endl;
+                                }
+                            }
+                        }
+                        bytesSinceBitrateArbitration = 0;
+                        lastBitrateArbitration = NOW;
+                    }
+                }
+
+                if (rtpSender && VERBOSE && (RTP_STATISTICS_INTERVAL <= std::chrono::steady_clock::now() - lastRTPStatistics)) {
+                    const DatagramSender::Statistics SENDER{rtpSender->statistics()};
+                    std::clog << argv[0] << ": Sent " << SENDER.m_datagrams << " RTP packets (" << SENDER.m_bytes << " bytes) using " << SENDER.m_systemCalls << " system calls" << (rtpSender->usesSegmentationOffload() ? " with UDP segmentation offload" : "") << "; " << SENDER.m_failedDatagrams << " failed." << std::endl;
+                    if (rtpPacer) {
+                        const Pacer::Statistics PACING{rtpPacer->statistics()};
+                        std::clog << argv[0] << ": Paced " << PACING.m_datagrams << " RTP packets; queueing delay mean = " << PACING.m_meanQueueingDelay.count() << " microseconds, max = " << PACING.m_maximumQueueingDelay.count() << " microseconds; dropped " << PACING.m_droppedDatagrams << " packets." << std::endl;
+                    }
+                    lastRTPStatistics = std::chrono::steady_clock::now();
+                }
+
+                if ( (0 < ENCODER_STATS) && (ENCODER_STATISTICS_INTERVAL <= std::chrono::steady_clock::now() - lastEncoderStatistics) ) {
+                    SEncoderStatistics statistics;
+                    memset(&statistics, 0, sizeof(SEncoderStatistics));
+                    if (cmResultSuccess == encoder->GetOption(ENCODER_OPTION_GET_STATISTICS, &statistics)) {
+                        opendlv::video::EncoderStatistics encoderStatistics;
+                        encoderStatistics.inputFrames(statistics.uiInputFrameCount)
+                                         .skippedFrames(statistics.uiSkippedFrameCount)
+                                         .idrRequests(statistics.uiIDRReqNum)
+                                         .idrFrames(statistics.uiIDRSentNum)
+                                         .ltrFrames(statistics.uiLTRSentNum)
+                                         .averageFrameRate(statistics.fAverageFrameRate)
+                                         .latestFrameRate(statistics.fLatestFrameRate)
+                                         .bitrate(statistics.uiBitRate)
+                                         .targetBitrate(currentBitrate)
+                                         .averageQp(statistics.uiAverageFrameQP)
+                                         .averageEncodingTime(statistics.fAverageFrameSpeedInMs)
+                                         .totalEncodedBytes(static_cast<uint64_t>(statistics.iTotalEncodedBytes));
+                        const cluon::data::TimeStamp NOW{cluon::time::now()};
+                        od4.send(std::move(messageSerializer.serialize(encoderStatistics, NOW, NOW)));
+                        if (VERBOSE) {
+                            std::clog << argv[0] << ": Encoder statistics: " << statistics.uiInputFrameCount << " frames (" << statistics.uiSkippedFrameCount << " skipped, "
+                                      << statistics.uiIDRSentNum << " IDR, " << statistics.uiIDRReqNum << " IDR requests), " << statistics.fLatestFrameRate << " fps, "
+                                      << statistics.uiBitRate << " bps (target " << currentBitrate << " bps), QP " << statistics.uiAverageFrameQP << ", " << statistics.fAverageFrameSpeedInMs << " ms per frame." << std::endl;
+                        }
                     }
+                    lastEncoderStatistics = std::chrono::steady_clock::now();
                 }
             }
             if (nullptr != encoder) {
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pacer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+Pacer::Pacer(DatagramSender &sender, uint64_t bitsPerSecond, std::size_t burstSize, std::size_t maximumDatagramSize, uint32_t numberOfDatagrams) noexcept
+    : m_sender{sender}
+    , m_bytesPerNanosecond{static_cast<double>(bitsPerSecond) / 8.0 / 1e9}
+    // A datagram larger than the bucket could never be sent.
+    , m_burstSize{static_cast<double>(std::max(burstSize, maximumDatagramSize))}
+    , m_datagrams{maximumDatagramSize, numberOfDatagrams} {
+    if (m_datagrams.valid() && (0 < bitsPerSecond)) {
+        m_queue.resize(numberOfDatagrams, Datagram{nullptr, 0, std::chrono::steady_clock::time_point{}, nullptr});
+        m_running.store(true);
+        m_senderThread = std::thread(&Pacer::sendDatagrams, this);
+    }
+}
+
+Pacer::~Pacer() noexcept {
+    if (m_running.load()) {
+        {
+            std::lock_guard<std::mutex> lck(m_queueMutex);
+            m_running.store(false);
+        }
+        m_queueCondition.notify_all();
+    }
+    if (m_senderThread.joinable()) {
+        m_senderThread.join();
+    }
+}
+
+bool Pacer::isRunning() const noexcept {
+    return m_running.load();
+}
+
+bool Pacer::send(const uint8_t *data, std::size_t length) noexcept {
+    return send(data, length, m_sender);
+}
+
+bool Pacer::send(const uint8_t *data, std::size_t length, DatagramSender &sender) noexcept {
+    uint8_t *buffer{nullptr};
+    if (m_running.load() && (m_datagrams.bufferSize() >= length)) {
+        buffer = m_datagrams.acquire();
+    }
+    if (nullptr == buffer) {
+        std::lock_guard<std::mutex> lck(m_statisticsMutex);
+        m_statistics.m_droppedDatagrams++;
+        return false;
+    }
+    memcpy(buffer, data, length);
+    {
+        // The queue can hold all buffers of the pool; hence, it never overflows.
+        std::lock_guard<std::mutex> lck(m_queueMutex);
+        m_queue[(m_queueHead + m_queueCount) % m_queue.size()] = Datagram{buffer, length, std::chrono::steady_clock::now(), &sender};
+        m_queueCount++;
+    }
+    m_queueCondition.notify_one();
+    return true;
+}
+
+Pacer::Statistics Pacer::statistics() noexcept {
+    std::lock_guard<std::mutex> lck(m_statisticsMutex);
+    Statistics statistics{m_statistics};
+    if (0 < statistics.m_datagrams) {
+        statistics.m_meanQueueingDelay = m_sumOfQueueingDelays / statistics.m_datagrams;
+    }
+    m_statistics = Statistics{};
+    m_sumOfQueueingDelays = std::chrono::microseconds{0};
+    return statistics;
+}
+
+void Pacer::sendDatagrams() noexcept {
+    double tokens{m_burstSize};
+    std::chrono::steady_clock::time_point lastRefill{std::chrono::steady_clock::now()};
+    while (true) {
+        std::size_t queued{0};
+        {
+            std::unique_lock<std::mutex> lck(m_queueMutex);
+            m_queueCondition.wait(lck, [this](){ return (0 < m_queueCount) || !m_running.load(); });
+            if (!m_running.load()) {
+                break;
+            }
+            queued = m_queueCount;
+        }
+
+        const auto NOW{std::chrono::steady_clock::now()};
+        tokens = std::min(m_burstSize, tokens + m_bytesPerNanosecond * static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(NOW - lastRefill).count()));
+        lastRefill = NOW;
+
+        // Send as many datagrams in one batch as the tokens allow. Only this thread
+        // removes datagrams; hence, the queued ones remain valid without holding the lock.
+        DatagramSender *senders[MAXIMUM_SENDERS_PER_BATCH]{};
+        uint32_t appended[MAXIMUM_SENDERS_PER_BATCH]{};
+        std::size_t batchSize{0};
+        double batchLength{0};
+        for (; batchSize < queued; batchSize++) {
+            const Datagram &datagram = m_queue[(m_queueHead + batchSize) % m_queue.size()];
+            if (tokens < batchLength + static_cast<double>(datagram.m_length)) {
+                break;
+            }
+            std::size_t s{0};
+            while ( (s < MAXIMUM_SENDERS_PER_BATCH) && (nullptr != senders[s]) && (datagram.m_sender != senders[s]) ) {
+                s++;
+            }
+            // A full sender would flush on its own and hide the datagrams it failed to send.
+            if ( (MAXIMUM_SENDERS_PER_BATCH == s) || ( (nullptr != senders[s]) && (senders[s]->maximumBatchSize() == appended[s]) ) ) {
+                break;
+            }
+            senders[s] = datagram.m_sender;
+            senders[s]->append(datagram.m_data, datagram.m_length);
+            appended[s]++;
+            batchLength += static_cast<double>(datagram.m_length);
+        }
+        if (0 == batchSize) {
+            const double MISSING{static_cast<double>(m_queue[m_queueHead].m_length) - tokens};
+            std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<int64_t>(MISSING / m_bytesPerNanosecond)));
+            continue;
+        }
+        tokens -= batchLength;
+
+        uint32_t sent{0};
+        for (std::size_t s{0}; (s < MAXIMUM_SENDERS_PER_BATCH) && (nullptr != senders[s]); s++) {
+            sent += senders[s]->flush();
+        }
+        const auto SENT_AT{std::chrono::steady_clock::now()};
+        {
+            std::lock_guard<std::mutex> lck(m_statisticsMutex);
+            m_statistics.m_droppedDatagrams += batchSize - sent;
+            for (std::size_t i{0}; i < batchSize; i++) {
+                const auto QUEUEING_DELAY{std::chrono::duration_cast<std::chrono::microseconds>(SENT_AT - m_queue[(m_queueHead + i) % m_queue.size()].m_queued)};
+                m_sumOfQueueingDelays += QUEUEING_DELAY;
+                m_statistics.m_maximumQueueingDelay = std::max(m_statistics.m_maximumQueueingDelay, QUEUEING_DELAY);
+            }
+            m_statistics.m_datagrams += sent;
+        }
+        for (std::size_t i{0}; i < batchSize; i++) {
+            m_datagrams.release(m_queue[(m_queueHead + i) % m_queue.size()].m_data);
+        }
+        {
+            std::lock_guard<std::mutex> lck(m_queueMutex);
+            m_queueHead = (m_queueHead + batchSize) % m_queue.size();
+            m_queueCount -= batchSize;
+        }
+    }
+
+    // Release the datagrams that were not sent anymore.
+    std::lock_guard<std::mutex> lck(m_queueMutex);
+    for (; 0 < m_queueCount; m_queueCount--) {
+        m_datagrams.release(m_queue[m_queueHead].m_data);
+        m_queueHead = (m_queueHead + 1) % m_queue.size();
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PACER_HPP
+#define PACER_HPP
+
+#include "buffer-pool.hpp"
+#include "datagram-sender.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * This class spreads datagrams over time using a token bucket: Datagrams are
+ * copied into a queue of pre-faulted buffers, and a dedicated thread sends
+ * as many of them in one batch as tokens are available; tokens accumulate at the
+ * pacing rate up to the burst size. A large IDR frame thus leaves the host
+ * over several milliseconds instead of as one burst that overflows the
+ * buffers of switches and radio links. The time datagrams spend in the queue
+ * is measured to tune the pacing rate against the added latency.
+ *
+ * Datagrams for other senders, like parity packets to another port, can be
+ * queued as well so that they share the pacing rate and the order with the
+ * datagrams they belong to.
+ */
+class Pacer {
+   private:
+    Pacer(const Pacer &) = delete;
+    Pacer(Pacer &&)      = delete;
+    Pacer &operator=(const Pacer &) = delete;
+    Pacer &operator=(Pacer &&) = delete;
+
+   public:
+    class Statistics {
+       public:
+        uint64_t m_datagrams{0};
+        uint64_t m_droppedDatagrams{0};
+        std::chrono::microseconds m_meanQueueingDelay{0};
+        std::chrono::microseconds m_maximumQueueingDelay{0};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param sender Default sender to send the paced datagrams with; it must outlive this pacer.
+     * @param bitsPerSecond Pacing rate.
+     * @param burstSize Maximum number of bytes sent at once.
+     * @param maximumDatagramSize Maximum size of one datagram.
+     * @param numberOfDatagrams Maximum number of queued datagrams.
+     */
+    Pacer(DatagramSender &sender, uint64_t bitsPerSecond, std::size_t burstSize, std::size_t maximumDatagramSize, uint32_t numberOfDatagrams) noexcept;
+    ~Pacer() noexcept;
+
+   public:
+    /**
+     * @return true if the pacer is sending.
+     */
+    bool isRunning() const noexcept;
+
+    /**
+     * This method queues a datagram; it never blocks.
+     *
+     * @param data Datagram to send.
+     * @param length Length of the datagram.
+     * @return true if the datagram was queued; false if it had to be dropped.
+     */
+    bool send(const uint8_t *data, std::size_t length) noexcept;
+
+    /**
+     * This method queues a datagram to be sent with another sender; it never blocks.
+     *
+     * @param data Datagram to send.
+     * @param length Length of the datagram.
+     * @param sender Sender to send the datagram with; it must outlive this pacer.
+     * @return true if the datagram was queued; false if it had to be dropped.
+     */
+    bool send(const uint8_t *data, std::size_t length, DatagramSender &sender) noexcept;
+
+    /**
+     * @return Statistics since the last call.
+     */
+    Statistics statistics() noexcept;
+
+   private:
+    class Datagram {
+       public:
+        uint8_t *m_data;
+        std::size_t m_length;
+        std::chrono::steady_clock::time_point m_queued;
+        DatagramSender *m_sender;
+    };
+
+    // A batch ends when a datagram needs yet another sender.
+    static constexpr std::size_t MAXIMUM_SENDERS_PER_BATCH{2};
+
+    void sendDatagrams() noexcept;
+
+   private:
+    DatagramSender &m_sender;
+    const double m_bytesPerNanosecond;
+    const double m_burstSize;
+
+    BufferPool m_datagrams;
+
+    std::mutex m_queueMutex{};
+    std::condition_variable m_queueCondition{};
+    std::vector<Datagram> m_queue{};
+    std::size_t m_queueHead{0};
+    std::size_t m_queueCount{0};
+
+    std::mutex m_statisticsMutex{};
+    Statistics m_statistics{};
+    std::chrono::microseconds m_sumOfQueueingDelays{0};
+
+    std::atomic<bool> m_running{false};
+    std::thread m_senderThread{};
+};
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quality-monitor.hpp"
+#include "image-kernels.hpp"
+
+#include <wels/codec_api.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+// Enough frames to bridge the time to decode an IDR frame.
+constexpr uint32_t QUEUED_FRAMES{8};
+
+// Reported for identical planes instead of infinity.
+constexpr double MAXIMUM_PSNR{99.99};
+
+double psnr(uint64_t sumOfSquaredDifferences, uint64_t numberOfPixels) noexcept {
+    if (0 == sumOfSquaredDifferences) {
+        return MAXIMUM_PSNR;
+    }
+    const double MSE{static_cast<double>(sumOfSquaredDifferences) / static_cast<double>(numberOfPixels)};
+    return std::min(MAXIMUM_PSNR, 10.0 * std::log10((255.0 * 255.0) / MSE));
+}
+}
+
+QualityMonitor::QualityMonitor(uint32_t width, uint32_t height, std::size_t maximumFrameSize, uint32_t sampleInterval, uint32_t window, std::function<void(const Summary &)> delegate, bool useHugePages) noexcept
+    : m_width{width}
+    , m_height{height}
+    , m_sampleInterval{std::max(sampleInterval, 1u)}
+    , m_window{std::max(window, 1u)}
+    , m_delegate{delegate}
+    , m_bitstreams{maximumFrameSize, QUEUED_FRAMES, useHugePages}
+    // Source frames are sparse; hence, two buffers suffice.
+    , m_sourceFrames{static_cast<std::size_t>(width) * height * 3 / 2, 2, useHugePages} {
+    if (m_bitstreams.valid() && m_sourceFrames.valid() && (0 == WelsCreateDecoder(&m_decoder)) && (nullptr != m_decoder)) {
+        SDecodingParam parameters;
+        memset(&parameters, 0, sizeof(SDecodingParam));
+        parameters.sVideoProperty.eVideoBsType = VIDEO_BITSTREAM_AVC;
+        // Concealed frames would be compared as if they were decoded correctly.
+        parameters.eEcActiveIdc = ERROR_CON_DISABLE;
+        if (0 == m_decoder->Initialize(&parameters)) {
+            m_queue.resize(QUEUED_FRAMES, Frame{nullptr, 0, nullptr, cluon::data::TimeStamp{}});
+            m_running.store(true);
+            m_decoderThread = std::thread(&QualityMonitor::decodeFrames, this);
+        }
+        else {
+            std::cerr << "[QualityMonitor]: Failed to initialize openh264 decoder." << std::endl;
+        }
+    }
+}
+
+QualityMonitor::~QualityMonitor() noexcept {
+    if (m_running.load()) {
+        {
+            std::lock_guard<std::mutex> lck(m_queueMutex);
+            m_running.store(false);
+        }
+        m_queueCondition.notify_all();
+    }
+    if (m_decoderThread.joinable()) {
+        m_decoderThread.join();
+    }
+    if (nullptr != m_decoder) {
+        m_decoder->Uninitialize();
+        WelsDestroyDecoder(m_decoder);
+        m_decoder = nullptr;
+    }
+}
+
+bool QualityMonitor::isRunning() const noexcept {
+    return m_running.load();
+}
+
+uint64_t QualityMonitor::droppedFrames() const noexcept {
+    return m_droppedFrames.load();
+}
+
+uint8_t *QualityMonitor::acquireSourceFrame() noexcept {
+    if (!m_running.load() || m_waitForIDR) {
+        // Frames until the next IDR frame are not decoded at all.
+        return nullptr;
+    }
+    return (0 == (m_frameCounter % m_sampleInterval)) ? m_sourceFrames.acquire() : nullptr;
+}
+
+bool QualityMonitor::submit(const uint8_t *data, std::size_t length, bool isIDR, uint8_t *sourceFrame, const cluon::data::TimeStamp &sampleTimeStamp) noexcept {
+    m_frameCounter++;
+    if (!m_running.load()) {
+        return false;
+    }
+    if (isIDR) {
+        m_waitForIDR = false;
+    }
+    uint8_t *bitstream{nullptr};
+    if (!m_waitForIDR && (m_bitstreams.bufferSize() >= length)) {
+        bitstream = m_bitstreams.acquire();
+    }
+    if (nullptr == bitstream) {
+        // Frames referring to a missing frame cannot be decoded correctly; hence, resume at the next IDR frame.
+        if (nullptr != sourceFrame) {
+            m_sourceFrames.release(sourceFrame);
+        }
+        m_droppedFrames++;
+        m_waitForIDR = true;
+        return false;
+    }
+    memcpy(bitstream, data, length);
+    {
+        // The queue can hold all bitstream buffers; hence, it never overflows.
+        std::lock_guard<std::mutex> lck(m_queueMutex);
+        m_queue[(m_queueHead + m_queueCount) % m_queue.size()] = Frame{bitstream, length, sourceFrame, sampleTimeStamp};
+        m_queueCount++;
+    }
+    m_queueCondition.notify_one();
+    return true;
+}
+
+void QualityMonitor::decodeFrames() noexcept {
+    while (true) {
+        Frame frame{nullptr, 0, nullptr, cluon::data::TimeStamp{}};
+        {
+            std::unique_lock<std::mutex> lck(m_queueMutex);
+            m_queueCondition.wait(lck, [this](){ return (0 < m_queueCount) || !m_running.load(); });
+            if (!m_running.load()) {
+                break;
+            }
+            frame = m_queue[m_queueHead];
+            m_queueHead = (m_queueHead + 1) % m_queue.size();
+            m_queueCount--;
+        }
+
+        // Every frame is decoded to keep the decoder's reference frames in sync.
+        uint8_t *decoded[3]{nullptr, nullptr, nullptr};
+        SBufferInfo bufferInfo;
+        memset(&bufferInfo, 0, sizeof(SBufferInfo));
+        const DECODING_STATE STATE{m_decoder->DecodeFrameNoDelay(frame.m_data, static_cast<int>(frame.m_length), decoded, &bufferInfo)};
+        if ( (dsErrorFree == STATE) && (1 == bufferInfo.iBufferStatus) && (nullptr != frame.m_sourceFrame) ) {
+            const int32_t STRIDES[2]{bufferInfo.UsrData.sSystemBuffer.iStride[0], bufferInfo.UsrData.sSystemBuffer.iStride[1]};
+            compare(frame, decoded, STRIDES);
+        }
+        else if (dsErrorFree != STATE) {
+            std::cerr << "[QualityMonitor]: Failed to decode h264 frame: " << STATE << std::endl;
+        }
+
+        if (nullptr != frame.m_sourceFrame) {
+            m_sourceFrames.release(frame.m_sourceFrame);
+        }
+        m_bitstreams.release(frame.m_data);
+    }
+
+    // Return the buffers of frames that were not decoded anymore.
+    std::lock_guard<std::mutex> lck(m_queueMutex);
+    for (; 0 < m_queueCount; m_queueCount--) {
+        if (nullptr != m_queue[m_queueHead].m_sourceFrame) {
+            m_sourceFrames.release(m_queue[m_queueHead].m_sourceFrame);
+        }
+        m_bitstreams.release(m_queue[m_queueHead].m_data);
+        m_queueHead = (m_queueHead + 1) % m_queue.size();
+    }
+}
+
+void QualityMonitor::compare(const Frame &frame, uint8_t **decoded, const int32_t *strides) noexcept {
+    const uint32_t CHROMA_WIDTH{m_width / 2};
+    const uint32_t CHROMA_HEIGHT{m_height / 2};
+    const uint8_t *sourceY = frame.m_sourceFrame;
+    const uint8_t *sourceU = sourceY + static_cast<std::size_t>(m_width) * m_height;
+    const uint8_t *sourceV = sourceU + static_cast<std::size_t>(CHROMA_WIDTH) * CHROMA_HEIGHT;
+
+    const uint64_t SSE_Y{sumOfSquaredDifferences(sourceY, m_width, decoded[0], static_cast<uint32_t>(strides[0]), m_width, m_height)};
+    const uint64_t SSE_U{sumOfSquaredDifferences(sourceU, CHROMA_WIDTH, decoded[1], static_cast<uint32_t>(strides[1]), CHROMA_WIDTH, CHROMA_HEIGHT)};
+    const uint64_t SSE_V{sumOfSquaredDifferences(sourceV, CHROMA_WIDTH, decoded[2], static_cast<uint32_t>(strides[1]), CHROMA_WIDTH, CHROMA_HEIGHT)};
+    const uint64_t PIXELS_Y{static_cast<uint64_t>(m_width) * m_height};
+    const uint64_t PIXELS_UV{static_cast<uint64_t>(CHROMA_WIDTH) * CHROMA_HEIGHT};
+
+    const double PSNR_Y{psnr(SSE_Y, PIXELS_Y)};
+    const double PSNR{psnr(SSE_Y + SSE_U + SSE_V, PIXELS_Y + 2 * PIXELS_UV)};
+    const double SSIM_Y{meanSSIM(sourceY, m_width, decoded[0], static_cast<uint32_t>(strides[0]), m_width, m_height)};
+
+    if (0 == m_summary.m_samples) {
+        m_summary.m_minPSNRY = std::numeric_limits<float>::max();
+        m_summary.m_minSSIMY = std::numeric_limits<float>::max();
+    }
+    m_summary.m_samples++;
+    m_summary.m_minPSNRY = std::min(m_summary.m_minPSNRY, static_cast<float>(PSNR_Y));
+    m_summary.m_minSSIMY = std::min(m_summary.m_minSSIMY, static_cast<float>(SSIM_Y));
+    m_sumPSNRY += PSNR_Y;
+    m_sumPSNR += PSNR;
+    m_sumSSIMY += SSIM_Y;
+
+    if (m_window <= m_summary.m_samples) {
+        m_summary.m_meanPSNRY = static_cast<float>(m_sumPSNRY / m_summary.m_samples);
+        m_summary.m_meanPSNR = static_cast<float>(m_sumPSNR / m_summary.m_samples);
+        m_summary.m_meanSSIMY = static_cast<float>(m_sumSSIMY / m_summary.m_samples);
+        const uint64_t DROPPED_FRAMES{m_droppedFrames.load()};
+        m_summary.m_droppedFrames = static_cast<uint32_t>(DROPPED_FRAMES - m_droppedFramesInLastSummary);
+        m_summary.m_sampleTimeStamp = frame.m_sampleTimeStamp;
+        if (m_delegate) {
+            m_delegate(m_summary);
+        }
+        m_droppedFramesInLastSummary = DROPPED_FRAMES;
+        m_summary = Summary{};
+        m_sumPSNRY = m_sumPSNR = m_sumSSIMY = 0;
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUALITY_MONITOR_HPP
+#define QUALITY_MONITOR_HPP
+
+#include "buffer-pool.hpp"
+#include "cluon-complete.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ISVCDecoder;
+
+/**
+ * This class measures the quality of the encoded stream the way a consumer
+ * sees it: A dedicated thread decodes the h264 frames with openh264's decoder
+ * and compares every n-th decoded frame against a copy of its I420 source
+ * frame using PSNR and SSIM. Frames are queued in pre-faulted buffers so that
+ * the caller neither decodes nor blocks; when the decoder falls behind, frames
+ * are dropped until the next IDR frame from which the decoder can resume.
+ */
+class QualityMonitor {
+   private:
+    QualityMonitor(const QualityMonitor &) = delete;
+    QualityMonitor(QualityMonitor &&)      = delete;
+    QualityMonitor &operator=(const QualityMonitor &) = delete;
+    QualityMonitor &operator=(QualityMonitor &&) = delete;
+
+   public:
+    class Summary {
+       public:
+        uint32_t m_samples{0};
+        float m_meanPSNRY{0};
+        float m_minPSNRY{0};
+        float m_meanPSNR{0};
+        float m_meanSSIMY{0};
+        float m_minSSIMY{0};
+        uint32_t m_droppedFrames{0};
+        cluon::data::TimeStamp m_sampleTimeStamp{};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param width Width of the frames.
+     * @param height Height of the frames.
+     * @param maximumFrameSize Maximum size in bytes of an h264 frame.
+     * @param sampleInterval Compare every this many frames.
+     * @param window Number of compared frames to summarize.
+     * @param delegate Function called from the monitoring thread with the summary of every window.
+     * @param useHugePages Back the frame buffers with 2 MB huge pages.
+     */
+    QualityMonitor(uint32_t width, uint32_t height, std::size_t maximumFrameSize, uint32_t sampleInterval, uint32_t window, std::function<void(const Summary &)> delegate, bool useHugePages = false) noexcept;
+    ~QualityMonitor() noexcept;
+
+   public:
+    /**
+     * @return true if the decoder and the buffers could be created.
+     */
+    bool isRunning() const noexcept;
+
+    /**
+     * This method returns a buffer to copy the I420 source frame of the next
+     * h264 frame into when this frame is to be compared; the buffer must be
+     * passed to submit().
+     *
+     * @return Buffer of width * height * 3 / 2 bytes or nullptr.
+     */
+    uint8_t *acquireSourceFrame() noexcept;
+
+    /**
+     * This method queues an h264 frame for decoding; it never blocks on decoding.
+     *
+     * @param data h264 frame (Annex-B).
+     * @param length Length of the h264 frame.
+     * @param isIDR true if the frame is an IDR frame.
+     * @param sourceFrame Buffer from acquireSourceFrame() or nullptr.
+     * @param sampleTimeStamp Sample time stamp of the frame.
+     * @return true if the frame was queued; false if it had to be dropped.
+     */
+    bool submit(const uint8_t *data, std::size_t length, bool isIDR, uint8_t *sourceFrame, const cluon::data::TimeStamp &sampleTimeStamp) noexcept;
+
+    /**
+     * @return Number of frames that were dropped as the decoder was behind.
+     */
+    uint64_t droppedFrames() const noexcept;
+
+   private:
+    class Frame {
+       public:
+        uint8_t *m_data;
+        std::size_t m_length;
+        uint8_t *m_sourceFrame;
+        cluon::data::TimeStamp m_sampleTimeStamp;
+    };
+
+    void decodeFrames() noexcept;
+    void compare(const Frame &frame, uint8_t **decoded, const int32_t *strides) noexcept;
+
+   private:
+    const uint32_t m_width;
+    const uint32_t m_height;
+    const uint32_t m_sampleInterval;
+    const uint32_t m_window;
+    std::function<void(const Summary &)> m_delegate;
+
+    BufferPool m_bitstreams;
+    BufferPool m_sourceFrames;
+    ISVCDecoder *m_decoder{nullptr};
+    uint32_t m_frameCounter{0};
+    bool m_waitForIDR{true};
+
+    std::mutex m_queueMutex{};
+    std::condition_variable m_queueCondition{};
+    std::vector<Frame> m_queue{};
+    std::size_t m_queueHead{0};
+    std::size_t m_queueCount{0};
+
+    // Only accessed from the monitoring thread.
+    Summary m_summary{};
+    double m_sumPSNRY{0};
+    double m_sumPSNR{0};
+    double m_sumSSIMY{0};
+    uint64_t m_droppedFramesInLastSummary{0};
+
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_droppedFrames{0};
+    std::thread m_decoderThread{};
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "realtime-tuning.hpp"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+std::vector<uint32_t> parseCpuList(const std::string &cpuList) noexcept {
+    std::vector<uint32_t> cpus;
+    try {
+        std::stringstream sstr(cpuList);
+        std::string range;
+        while (std::getline(sstr, range, ',')) {
+            if (range.empty()) {
+                continue;
+            }
+            const auto dash = range.find('-');
+            const uint32_t FIRST{static_cast<uint32_t>(std::stoul(range.substr(0, dash)))};
+            const uint32_t LAST{(std::string::npos == dash) ? FIRST : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)))};
+            if ( (LAST < FIRST) || (CPU_SETSIZE <= LAST) ) {
+                return std::vector<uint32_t>();
+            }
+            for (uint32_t cpu{FIRST}; cpu <= LAST; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    }
+    catch (...) {
+        cpus.clear();
+    }
+    return cpus;
+}
+
+int32_t pinCurrentThread(const std::vector<uint32_t> &cpus) noexcept {
+    if (cpus.empty()) {
+        return EINVAL;
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto cpu : cpus) {
+        CPU_SET(cpu, &cpuSet);
+    }
+    // pthread_setaffinity_np returns the error number instead of setting errno.
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+}
+
+bool setRealtimePriority(int32_t priority) noexcept {
+    const int32_t MIN{sched_get_priority_min(SCHED_FIFO)};
+    const int32_t MAX{sched_get_priority_max(SCHED_FIFO)};
+    struct sched_param schedulingParameters;
+    std::memset(&schedulingParameters, 0, sizeof(schedulingParameters));
+    schedulingParameters.sched_priority = std::min(std::max(priority, MIN), MAX);
+    return (0 == pthread_setschedparam(pthread_self(), SCHED_FIFO, &schedulingParameters));
+}
+
+int32_t numaNodeOfCpu(uint32_t cpu) noexcept {
+    int32_t node{-1};
+    const std::string PATH{"/sys/devices/system/cpu/cpu" + std::to_string(cpu)};
+    DIR *dir = ::opendir(PATH.c_str());
+    if (nullptr != dir) {
+        struct dirent *entry{nullptr};
+        while ( (-1 == node) && (nullptr != (entry = ::readdir(dir))) ) {
+            if ( (0 == std::strncmp(entry->d_name, "node", 4)) && (0 != std::isdigit(entry->d_name[4])) ) {
+                node = std::atoi(entry->d_name + 4);
+            }
+        }
+        ::closedir(dir);
+    }
+    return node;
+}
+
+bool preferNumaNode(int32_t node) noexcept {
+    // Using the raw system call avoids a dependency on libnuma.
+    constexpr int MPOL_PREFERRED{1};
+    constexpr uint32_t BITS_PER_MASK{8 * sizeof(unsigned long)};
+    if ( (0 > node) || (BITS_PER_MASK <= static_cast<uint32_t>(node)) ) {
+        return false;
+    }
+    unsigned long nodeMask{1UL << node};
+    return (0 == ::syscall(SYS_set_mempolicy, MPOL_PREFERRED, &nodeMask, BITS_PER_MASK + 1));
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REALTIME_TUNING_HPP
+#define REALTIME_TUNING_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * This method parses a list of CPUs in the format used by taskset and
+ * /sys/devices/system/cpu (e.g., "0-3,8,10-11").
+ *
+ * @param cpuList List of CPUs to parse.
+ * @return Sorted CPU indices or an empty vector when the list is malformed.
+ */
+std::vector<uint32_t> parseCpuList(const std::string &cpuList) noexcept;
+
+/**
+ * This method restricts the calling thread to the given CPUs. Threads that
+ * are created afterwards from the calling thread inherit this affinity.
+ *
+ * @param cpus CPU indices to run on.
+ * @return 0 if the affinity could be set or an error number otherwise.
+ */
+int32_t pinCurrentThread(const std::vector<uint32_t> &cpus) noexcept;
+
+/**
+ * This method switches the calling thread to SCHED_FIFO using the given
+ * priority (requires CAP_SYS_NICE). Threads that are created afterwards from
+ * the calling thread inherit this policy.
+ *
+ * @param priority Real-time priority [1 .. 99].
+ * @return true if the scheduling policy could be set.
+ */
+bool setRealtimePriority(int32_t priority) noexcept;
+
+/**
+ * @param cpu CPU index.
+ * @return NUMA node hosting the given CPU or -1 if unknown.
+ */
+int32_t numaNodeOfCpu(uint32_t cpu) noexcept;
+
+/**
+ * This method sets the memory policy of the calling thread to prefer the
+ * given NUMA node so that pages touched first by this thread are placed there.
+ *
+ * @param node NUMA node.
+ * @return true if the memory policy could be set.
+ */
+bool preferNumaNode(int32_t node) noexcept;
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "recorder.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+constexpr int32_t Recorder::FLUSH_INTERVAL_MS;
+
+Recorder::Recorder(const std::string &filename, uint64_t maximumFileSize, std::chrono::seconds maximumFileDuration, bool useDirectIO, std::size_t batchSize, uint32_t numberOfBatches) noexcept
+    : m_filename{filename}
+    , m_maximumFileSize{maximumFileSize}
+    , m_maximumFileDuration{maximumFileDuration}
+    , m_rotate{(0 < maximumFileSize) || (0 < maximumFileDuration.count())}
+    , m_useDirectIO{useDirectIO}
+    , m_batches{batchSize, numberOfBatches} {
+    // Opening the first file here lets the caller refuse to start with an unwritable file.
+    if (m_batches.valid() && openFile()) {
+        // One flush of the current batch may be queued in addition to all batches.
+        m_queue.resize(numberOfBatches + 1, Batch{nullptr, 0, false, false, 0});
+        m_spareBatches.reserve(numberOfBatches);
+        m_lastFlush = std::chrono::steady_clock::now();
+        m_running.store(true);
+        m_writerThread = std::thread(&Recorder::writeBatches, this);
+    }
+}
+
+Recorder::~Recorder() noexcept {
+    if (m_running.load()) {
+        if (nullptr != m_currentBatch.m_data) {
+            submitCurrentBatch(true);
+        }
+        {
+            std::lock_guard<std::mutex> lck(m_queueMutex);
+            m_running.store(false);
+        }
+        m_queueCondition.notify_all();
+    }
+    if (m_writerThread.joinable()) {
+        m_writerThread.join();
+    }
+}
+
+bool Recorder::isRunning() const noexcept {
+    return m_running.load();
+}
+
+uint64_t Recorder::droppedEnvelopes() const noexcept {
+    return m_droppedEnvelopes.load();
+}
+
+bool Recorder::append(const std::string &envelope) noexcept {
+    if (!m_running.load()) {
+        return false;
+    }
+    if (nullptr == m_currentBatch.m_data) {
+        m_currentBatch = Batch{m_batches.acquire(), 0, false, false, 0};
+    }
+    if ( (nullptr != m_currentBatch.m_data) && (0 < m_bytesInCurrentFile) && rotationIsDue() ) {
+        submitCurrentBatch(true);
+        m_currentBatch = Batch{m_batches.acquire(), 0, false, false, 0};
+        m_bytesInCurrentFile = 0;
+    }
+    if (nullptr == m_currentBatch.m_data) {
+        m_droppedEnvelopes++;
+        return false;
+    }
+
+    // Reserve all batches needed for this envelope upfront to never write partial envelopes.
+    const std::size_t BATCH_SIZE{m_batches.bufferSize()};
+    m_spareBatches.clear();
+    std::size_t available{BATCH_SIZE - m_currentBatch.m_length};
+    while (available < envelope.size()) {
+        uint8_t *batch = m_batches.acquire();
+        if (nullptr == batch) {
+            for (auto b : m_spareBatches) {
+                m_batches.release(b);
+            }
+            m_droppedEnvelopes++;
+            return false;
+        }
+        m_spareBatches.push_back(batch);
+        available += BATCH_SIZE;
+    }
+
+    const char *data = envelope.data();
+    std::size_t remaining{envelope.size()};
+    std::size_t nextSpareBatch{0};
+    while (0 < remaining) {
+        if (BATCH_SIZE == m_currentBatch.m_length) {
+            submitCurrentBatch(false);
+            m_currentBatch = Batch{m_spareBatches[nextSpareBatch++], 0, false, false, 0};
+        }
+        const std::size_t LENGTH{std::min(remaining, BATCH_SIZE - m_currentBatch.m_length)};
+        std::memcpy(m_currentBatch.m_data + m_currentBatch.m_length, data, LENGTH);
+        m_currentBatch.m_length += LENGTH;
+        data += LENGTH;
+        remaining -= LENGTH;
+    }
+    if (BATCH_SIZE == m_currentBatch.m_length) {
+        submitCurrentBatch(false);
+    }
+
+    const std::chrono::steady_clock::time_point NOW{std::chrono::steady_clock::now()};
+    if (0 == m_bytesInCurrentFile) {
+        m_currentFileOpened = NOW;
+    }
+    m_bytesInCurrentFile += envelope.size();
+
+    if ( (nullptr != m_currentBatch.m_data) && (m_flushedLength < m_currentBatch.m_length) && (std::chrono::milliseconds(FLUSH_INTERVAL_MS) <= NOW - m_lastFlush) ) {
+        flushCurrentBatch();
+    }
+    return true;
+}
+
+bool Recorder::rotationIsDue() const noexcept {
+    return ( (0 < m_maximumFileSize) && (m_maximumFileSize <= m_bytesInCurrentFile) )
+        || ( (0 < m_maximumFileDuration.count()) && (m_maximumFileDuration <= (std::chrono::steady_clock::now() - m_currentFileOpened)) );
+}
+
+bool Recorder::submitCurrentBatch(bool closesFile) noexcept {
+    if (nullptr == m_currentBatch.m_data) {
+        return false;
+    }
+    m_currentBatch.m_closesFile = closesFile;
+    {
+        // The queue can hold all batches of the pool; hence, it never overflows.
+        std::lock_guard<std::mutex> lck(m_queueMutex);
+        m_queue[(m_queueHead + m_queueCount) % m_queue.size()] = m_currentBatch;
+        m_queueCount++;
+    }
+    m_queueCondition.notify_one();
+    m_currentBatch = Batch{nullptr, 0, false, false, 0};
+    m_flushedLength = 0;
+    m_lastFlush = std::chrono::steady_clock::now();
+    return true;
+}
+
+void Recorder::flushCurrentBatch() noexcept {
+    {
+        // A slow disk must not pile up flushes; the next one covers the skipped data.
+        std::lock_guard<std::mutex> lck(m_queueMutex);
+        if (0 < m_pendingFlushes) {
+            return;
+        }
+        m_queue[(m_queueHead + m_queueCount) % m_queue.size()] = Batch{m_currentBatch.m_data, m_currentBatch.m_length, false, true, m_flushedLength};
+        m_queueCount++;
+        m_pendingFlushes++;
+    }
+    m_queueCondition.notify_one();
+    m_flushedLength = m_currentBatch.m_length;
+    m_lastFlush = std::chrono::steady_clock::now();
+}
+
+void Recorder::writeBatches() noexcept {
+    while (true) {
+        Batch batch{nullptr, 0, false, false, 0};
+        {
+            std::unique_lock<std::mutex> lck(m_queueMutex);
+            m_queueCondition.wait(lck, [this](){ return (0 < m_queueCount) || !m_running.load(); });
+            if (0 == m_queueCount) {
+                break;
+            }
+            batch = m_queue[m_queueHead];
+            m_queueHead = (m_queueHead + 1) % m_queue.size();
+            m_queueCount--;
+        }
+
+        if (batch.m_flushOnly) {
+            // The main thread keeps filling the batch beyond m_length; only the part before is read here.
+            if ( ( (-1 != m_fd) || openFile() ) && ( !m_useDirectIO || (-1 != m_flushFd) ) ) {
+                writeFully(m_useDirectIO ? m_flushFd : m_fd, batch.m_data + batch.m_flushFrom, batch.m_length - batch.m_flushFrom, static_cast<int64_t>(m_fileOffset + batch.m_flushFrom));
+            }
+            std::lock_guard<std::mutex> lck(m_queueMutex);
+            m_pendingFlushes--;
+            continue;
+        }
+
+        if ( (0 < batch.m_length) && ( (-1 != m_fd) || openFile() ) ) {
+            if (m_useDirectIO && (0 != (batch.m_length % m_batches.bufferSize()))) {
+                // Only the last batch of a file has an unaligned length.
+                int flags = ::fcntl(m_fd, F_GETFL);
+                ::fcntl(m_fd, F_SETFL, flags & ~O_DIRECT);
+            }
+            // Overwrites what was flushed of this batch before.
+            if (writeFully(m_fd, batch.m_data, batch.m_length, static_cast<int64_t>(m_fileOffset))) {
+                m_fileOffset += batch.m_length;
+            }
+        }
+        if (batch.m_closesFile) {
+            closeFile();
+        }
+        m_batches.release(batch.m_data);
+    }
+    closeFile();
+}
+
+bool Recorder::writeFully(int32_t fd, const uint8_t *data, std::size_t length, int64_t offset) noexcept {
+    std::size_t written{0};
+    while (written < length) {
+        ssize_t n = ::pwrite(fd, data + written, length - written, static_cast<off_t>(offset + static_cast<int64_t>(written)));
+        if (0 > n) {
+            if (EINTR == errno) {
+                continue;
+            }
+            std::cerr << "[Recorder]: Failed to write to '" << m_currentFilename << "': " << strerror(errno) << std::endl;
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool Recorder::openFile() noexcept {
+    m_currentFilename = m_filename;
+    if (m_rotate) {
+        const std::string EXTENSION{".rec"};
+        std::string base{m_filename};
+        if ( (base.size() > EXTENSION.size()) && (0 == base.compare(base.size() - EXTENSION.size(), EXTENSION.size(), EXTENSION)) ) {
+            base = base.substr(0, base.size() - EXTENSION.size());
+        }
+        char timeStamp[32];
+        std::time_t now = std::time(nullptr);
+        struct tm tm;
+        std::strftime(timeStamp, sizeof(timeStamp), "%Y-%m-%d_%H%M%S", ::localtime_r(&now, &tm));
+        m_currentFilename = base + "-" + timeStamp + EXTENSION;
+        struct stat fileStatus;
+        for (uint32_t i{1}; 0 == ::stat(m_currentFilename.c_str(), &fileStatus); i++) {
+            m_currentFilename = base + "-" + timeStamp + "_" + std::to_string(i) + EXTENSION;
+        }
+    }
+
+    const int FLAGS{O_WRONLY | O_CREAT | O_TRUNC};
+    const mode_t MODE{S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH};
+    m_fd = m_useDirectIO ? ::open(m_currentFilename.c_str(), FLAGS | O_DIRECT, MODE) : -1;
+    if ( (-1 == m_fd) && m_useDirectIO) {
+        // File systems like tmpfs do not support O_DIRECT.
+        std::cerr << "[Recorder]: O_DIRECT is not available for '" << m_currentFilename << "' (" << strerror(errno) << "); using buffered I/O." << std::endl;
+        m_useDirectIO = false;
+    }
+    if (-1 == m_fd) {
+        m_fd = ::open(m_currentFilename.c_str(), FLAGS, MODE);
+    }
+    if (-1 == m_fd) {
+        std::cerr << "[Recorder]: Failed to open '" << m_currentFilename << "': " << strerror(errno) << std::endl;
+    }
+    else if (m_useDirectIO) {
+        m_flushFd = ::open(m_currentFilename.c_str(), O_WRONLY);
+        if (-1 == m_flushFd) {
+            std::cerr << "[Recorder]: Failed to open '" << m_currentFilename << "' for flushing: " << strerror(errno) << "; partial batches are only written with the next batch." << std::endl;
+        }
+    }
+    m_fileOffset = 0;
+    return (-1 != m_fd);
+}
+
+void Recorder::closeFile() noexcept {
+    if (-1 != m_fd) {
+        ::fsync(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    if (-1 != m_flushFd) {
+        ::close(m_flushFd);
+        m_flushFd = -1;
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORDER_HPP
+#define RECORDER_HPP
+
+#include "buffer-pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * This class appends serialized OD4 envelopes to .rec files that can be
+ * replayed with cluon::Player. Envelopes are copied into large page-aligned
+ * batches that a dedicated thread writes to disk using O_DIRECT, so that the
+ * caller never blocks on file I/O. When all batches are in flight, envelopes
+ * are dropped and counted instead of stalling the caller.
+ *
+ * Files are rotated by size and/or age at envelope boundaries; only the last
+ * batch of a file is written without O_DIRECT as its length is not aligned.
+ *
+ * To bound the data lost on a crash, the filled part of the current batch is
+ * additionally written through the page cache every
+ * Recorder::FLUSH_INTERVAL_MS while envelopes are appended; the complete
+ * batch overwrites it later at the same offset.
+ */
+class Recorder {
+   private:
+    Recorder(const Recorder &) = delete;
+    Recorder(Recorder &&)      = delete;
+    Recorder &operator=(const Recorder &) = delete;
+    Recorder &operator=(Recorder &&) = delete;
+
+   public:
+    static constexpr int32_t FLUSH_INTERVAL_MS{1000};
+
+   public:
+    /**
+     * Constructor; the first file is opened right away.
+     *
+     * @param filename Name of the .rec file; when rotating, a time stamp is added to its name.
+     * @param maximumFileSize Rotate when a file exceeds this many bytes (0: never).
+     * @param maximumFileDuration Rotate when a file is older than this (0: never).
+     * @param useDirectIO Bypass the page cache using O_DIRECT if supported by the file system.
+     * @param batchSize Size of one batch written at once.
+     * @param numberOfBatches Number of batches to buffer.
+     */
+    Recorder(const std::string &filename, uint64_t maximumFileSize, std::chrono::seconds maximumFileDuration, bool useDirectIO, std::size_t batchSize = 4 * 1024 * 1024, uint32_t numberOfBatches = 8) noexcept;
+    ~Recorder() noexcept;
+
+   public:
+    /**
+     * @return true if the first file could be opened and the recorder is writing.
+     */
+    bool isRunning() const noexcept;
+
+    /**
+     * This method appends an envelope; it never blocks on disk I/O.
+     *
+     * @param envelope Serialized envelope.
+     * @return true if the envelope was queued; false if it had to be dropped.
+     */
+    bool append(const std::string &envelope) noexcept;
+
+    /**
+     * @return Number of envelopes that were dropped as all batches were in flight.
+     */
+    uint64_t droppedEnvelopes() const noexcept;
+
+   private:
+    class Batch {
+       public:
+        uint8_t *m_data;
+        std::size_t m_length;
+        bool m_closesFile;
+        // Only write [m_flushFrom, m_length) of the still filling batch; the batch is not handed over.
+        bool m_flushOnly;
+        std::size_t m_flushFrom;
+    };
+
+    bool rotationIsDue() const noexcept;
+    bool submitCurrentBatch(bool closesFile) noexcept;
+    void flushCurrentBatch() noexcept;
+    bool writeFully(int32_t fd, const uint8_t *data, std::size_t length, int64_t offset) noexcept;
+    void writeBatches() noexcept;
+    bool openFile() noexcept;
+    void closeFile() noexcept;
+
+   private:
+    const std::string m_filename;
+    const uint64_t m_maximumFileSize;
+    const std::chrono::seconds m_maximumFileDuration;
+    const bool m_rotate;
+    bool m_useDirectIO;
+
+    BufferPool m_batches;
+    Batch m_currentBatch{nullptr, 0, false, false, 0};
+    std::size_t m_flushedLength{0};
+    std::chrono::steady_clock::time_point m_lastFlush{};
+    std::vector<uint8_t*> m_spareBatches{};
+    uint64_t m_bytesInCurrentFile{0};
+    std::chrono::steady_clock::time_point m_currentFileOpened{};
+
+    std::mutex m_queueMutex{};
+    std::condition_variable m_queueCondition{};
+    std::vector<Batch> m_queue{};
+    std::size_t m_queueHead{0};
+    std::size_t m_queueCount{0};
+    uint32_t m_pendingFlushes{0};
+
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_droppedEnvelopes{0};
+    int32_t m_fd{-1};
+    // Buffered descriptor of the current file to flush unaligned data while m_fd uses O_DIRECT.
+    int32_t m_flushFd{-1};
+    uint64_t m_fileOffset{0};
+    std::string m_currentFilename{};
+    std::thread m_writerThread{};
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "remapper.hpp"
+#include "image-kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+constexpr uint32_t TILE_WIDTH{128};
+constexpr uint32_t TILE_HEIGHT{16};
+}
+
+Remapper::Remapper(const std::string &filename, uint32_t width, uint32_t height, bool lumaOnly) noexcept
+    : m_width{width}
+    , m_height{height}
+    , m_numberOfPlanes{lumaOnly ? 1u : 3u} {
+    if ( (2 > m_width / 2) || (2 > m_height / 2) || (0 != (m_width % 2)) || (0 != (m_height % 2)) ) {
+        std::cerr << "[Remapper]: Frames of " << m_width << "x" << m_height << " cannot be remapped." << std::endl;
+        return;
+    }
+
+    const std::size_t PIXELS{static_cast<std::size_t>(m_width) * m_height};
+    std::vector<float> map(PIXELS * 2);
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.good()) {
+            std::cerr << "[Remapper]: Failed to open '" << filename << "'." << std::endl;
+            return;
+        }
+        const std::streamoff SIZE{file.tellg()};
+        if (static_cast<std::streamoff>(map.size() * sizeof(float)) != SIZE) {
+            std::cerr << "[Remapper]: '" << filename << "' has " << SIZE << " bytes instead of " << map.size() * sizeof(float) << " for " << m_width << "x" << m_height << " pairs of floats." << std::endl;
+            return;
+        }
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(map.data()), SIZE)) {
+            std::cerr << "[Remapper]: Failed to read '" << filename << "'." << std::endl;
+            return;
+        }
+    }
+
+    setUpPlane(m_planes[0], m_width, m_height, 0, 0, [this, &map](uint32_t x, uint32_t y) {
+        const std::size_t I{2 * (static_cast<std::size_t>(y) * m_width + x)};
+        return std::make_pair(map[I], map[I + 1]);
+    });
+    // The center of a chroma pixel is at the center of its four luma pixels;
+    // a chroma position c corresponds to the luma position 2c + 0.5.
+    auto chromaPosition = [this, &map](uint32_t x, uint32_t y) {
+        float sumX{0.0f};
+        float sumY{0.0f};
+        for (uint32_t dy{0}; dy < 2; dy++) {
+            for (uint32_t dx{0}; dx < 2; dx++) {
+                const std::size_t I{2 * (static_cast<std::size_t>(2 * y + dy) * m_width + 2 * x + dx)};
+                sumX += map[I];
+                sumY += map[I + 1];
+            }
+        }
+        return std::make_pair((sumX / 4.0f - 0.5f) / 2.0f, (sumY / 4.0f - 0.5f) / 2.0f);
+    };
+    if (3 == m_numberOfPlanes) {
+        setUpPlane(m_planes[1], m_width / 2, m_height / 2, PIXELS, 128, chromaPosition);
+        setUpPlane(m_planes[2], m_width / 2, m_height / 2, PIXELS + PIXELS / 4, 128, chromaPosition);
+    }
+    m_valid = true;
+}
+
+template <typename POSITION>
+void Remapper::setUpPlane(Plane &plane, uint32_t width, uint32_t height, std::size_t offset, uint8_t border, POSITION &&position) noexcept {
+    plane.m_width = width;
+    plane.m_height = height;
+    plane.m_offset = offset;
+    plane.m_border = border;
+    plane.m_offsets.assign(static_cast<std::size_t>(width) * height, 0);
+    plane.m_weights.assign(static_cast<std::size_t>(width) * height * 2, 0);
+    plane.m_borderRuns.clear();
+
+    for (uint32_t y{0}; y < height; y++) {
+        for (uint32_t x{0}; x < width; x++) {
+            const uint32_t I{y * width + x};
+            const auto P{position(x, y)};
+            // Positions up to half a pixel outside are clamped to the edge; NaNs are outside.
+            const bool INSIDE{(-0.5f <= P.first) && (P.first <= width - 0.5f) && (-0.5f <= P.second) && (P.second <= height - 0.5f)};
+            if (!INSIDE) {
+                if (!plane.m_borderRuns.empty() && (plane.m_borderRuns.back().first + plane.m_borderRuns.back().second == I)) {
+                    plane.m_borderRuns.back().second++;
+                }
+                else {
+                    plane.m_borderRuns.emplace_back(I, 1);
+                }
+                continue;
+            }
+            const float X{std::min(std::max(P.first, 0.0f), static_cast<float>(width - 1))};
+            const float Y{std::min(std::max(P.second, 0.0f), static_cast<float>(height - 1))};
+            // The right and lower neighbours must exist; the last column and row are reached with full weights.
+            const uint32_t X0{std::min(static_cast<uint32_t>(X), width - 2)};
+            const uint32_t Y0{std::min(static_cast<uint32_t>(Y), height - 2)};
+            plane.m_offsets[I] = Y0 * width + X0;
+            plane.m_weights[2 * I] = static_cast<uint8_t>(std::lround((X - X0) * 128.0f));
+            plane.m_weights[2 * I + 1] = static_cast<uint8_t>(std::lround((Y - Y0) * 128.0f));
+        }
+    }
+
+    // Store the table in the order of the tiles so that it is read sequentially.
+    std::vector<uint32_t> offsets;
+    std::vector<uint8_t> weights;
+    offsets.reserve(plane.m_offsets.size());
+    weights.reserve(plane.m_weights.size());
+    for (uint32_t tileY{0}; tileY < height; tileY += TILE_HEIGHT) {
+        for (uint32_t tileX{0}; tileX < width; tileX += TILE_WIDTH) {
+            for (uint32_t y{tileY}; y < std::min(tileY + TILE_HEIGHT, height); y++) {
+                const std::size_t I{static_cast<std::size_t>(y) * width + tileX};
+                const std::size_t COLUMNS{std::min(TILE_WIDTH, width - tileX)};
+                offsets.insert(offsets.end(), plane.m_offsets.begin() + I, plane.m_offsets.begin() + I + COLUMNS);
+                weights.insert(weights.end(), plane.m_weights.begin() + 2 * I, plane.m_weights.begin() + 2 * (I + COLUMNS));
+            }
+        }
+    }
+    plane.m_offsets.swap(offsets);
+    plane.m_weights.swap(weights);
+}
+
+bool Remapper::valid() const noexcept {
+    return m_valid;
+}
+
+std::size_t Remapper::borderPixels() const noexcept {
+    std::size_t pixels{0};
+    for (const auto &run : m_planes[0].m_borderRuns) {
+        pixels += run.second;
+    }
+    return pixels;
+}
+
+void Remapper::remap(const uint8_t *source, uint8_t *destination) const noexcept {
+    const std::size_t FRAME_SIZE{static_cast<std::size_t>(m_width) * m_height * ((3 == m_numberOfPlanes) ? 3 : 2) / 2};
+    for (uint32_t i{0}; i < m_numberOfPlanes; i++) {
+        const Plane &plane{m_planes[i]};
+        std::size_t entry{0};
+        for (uint32_t tileY{0}; tileY < plane.m_height; tileY += TILE_HEIGHT) {
+            for (uint32_t tileX{0}; tileX < plane.m_width; tileX += TILE_WIDTH) {
+                const uint32_t COLUMNS{std::min(TILE_WIDTH, plane.m_width - tileX)};
+                for (uint32_t y{tileY}; y < std::min(tileY + TILE_HEIGHT, plane.m_height); y++) {
+                    const std::size_t I{static_cast<std::size_t>(y) * plane.m_width + tileX};
+                    remapBilinear(source + plane.m_offset, FRAME_SIZE - plane.m_offset, plane.m_width, plane.m_offsets.data() + entry, plane.m_weights.data() + 2 * entry, destination + plane.m_offset + I, COLUMNS);
+                    entry += COLUMNS;
+                }
+            }
+        }
+        for (const auto &run : plane.m_borderRuns) {
+            memset(destination + plane.m_offset + run.first, plane.m_border, run.second);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REMAPPER_HPP
+#define REMAPPER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * This class remaps I420 frames using a lookup table from a calibration, for
+ * instance to undistort or rectify images of fisheye lenses before encoding.
+ *
+ * The lookup table holds a pair of 32-bit floats (x, y) for every output pixel
+ * in row-major order with the position in the source frame to interpolate the
+ * luma from, as produced by OpenCV's initUndistortRectifyMap with CV_32FC2.
+ * The positions for the chroma planes are derived from the luma ones unless
+ * only the luma plane is remapped. Pixels mapped outside of the source frame
+ * are black.
+ *
+ * The table is converted once into offsets and 7-bit weights; frames are then
+ * remapped in tiles to keep the accessed source rows in the cache.
+ */
+class Remapper {
+   private:
+    Remapper(const Remapper &) = delete;
+    Remapper(Remapper &&)      = delete;
+    Remapper &operator=(const Remapper &) = delete;
+    Remapper &operator=(Remapper &&) = delete;
+
+   private:
+    class Plane {
+       public:
+        uint32_t m_width{0};
+        uint32_t m_height{0};
+        std::size_t m_offset{0};
+        uint8_t m_border{0};
+        std::vector<uint32_t> m_offsets{};
+        std::vector<uint8_t> m_weights{};
+        // Start and length of consecutive pixels mapped outside of the source.
+        std::vector<std::pair<uint32_t, uint32_t>> m_borderRuns{};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param filename Lookup table to load.
+     * @param width Width of source and remapped frames.
+     * @param height Height of source and remapped frames.
+     * @param lumaOnly true to remap only the luma plane of 8-bit grayscale frames.
+     */
+    Remapper(const std::string &filename, uint32_t width, uint32_t height, bool lumaOnly = false) noexcept;
+
+   public:
+    /**
+     * @return true if the lookup table was loaded.
+     */
+    bool valid() const noexcept;
+
+    /**
+     * @return Number of luma pixels mapped outside of the source frame.
+     */
+    std::size_t borderPixels() const noexcept;
+
+    /**
+     * This method remaps an I420 or grayscale frame.
+     *
+     * @param source Source frame.
+     * @param destination Remapped frame; it must not overlap with source.
+     */
+    void remap(const uint8_t *source, uint8_t *destination) const noexcept;
+
+   private:
+    template <typename POSITION>
+    void setUpPlane(Plane &plane, uint32_t width, uint32_t height, std::size_t offset, uint8_t border, POSITION &&position) noexcept;
+
+   private:
+    const uint32_t m_width;
+    const uint32_t m_height;
+    const uint32_t m_numberOfPlanes;
+    bool m_valid{false};
+    Plane m_planes[3]{};
+};
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rtp-fec.hpp"
+#include "rtp-packetizer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Parity packets waiting for the missing packets of their group.
+constexpr std::size_t MAXIMUM_PENDING_PARITY_PACKETS{64};
+
+uint16_t readUInt16(const uint8_t *data) noexcept {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+void writeUInt16(uint8_t *data, uint16_t value) noexcept {
+    data[0] = static_cast<uint8_t>(value >> 8);
+    data[1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+void xorInto(uint8_t *destination, const uint8_t *source, std::size_t length) noexcept {
+    for (std::size_t i{0}; i < length; i++) {
+        destination[i] ^= source[i];
+    }
+}
+}
+
+RTPFECEncoder::RTPFECEncoder(uint32_t groupSize, std::size_t maximumPacketSize) noexcept
+    : m_groupSize{std::min(std::max(groupSize, 1u), static_cast<uint32_t>(MAXIMUM_GROUP_SIZE))}
+    , m_maximumPacketSize{maximumPacketSize}
+    , m_parity(HEADER_SIZE + maximumPacketSize, 0) {
+}
+
+void RTPFECEncoder::add(const uint8_t *packet, std::size_t length, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    if ( (RTPPacketizer::RTP_HEADER_SIZE > length) || (m_maximumPacketSize < length) ) {
+        return;
+    }
+    if (0 == m_numberOfPackets) {
+        // Sequence number and SSRC of the group's first packet.
+        memcpy(m_parity.data() + 2, packet + 2, 2);
+        memcpy(m_parity.data() + 8, packet + 8, 4);
+    }
+    xorInto(m_parity.data() + HEADER_SIZE, packet, length);
+    m_parityLength = std::max(m_parityLength, length);
+    m_lengthRecovery = static_cast<uint16_t>(m_lengthRecovery ^ length);
+    m_numberOfPackets++;
+    if (m_groupSize == m_numberOfPackets) {
+        finish(delegate);
+    }
+}
+
+void RTPFECEncoder::finish(const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    if (0 == m_numberOfPackets) {
+        return;
+    }
+    m_parity[0] = VERSION;
+    m_parity[1] = static_cast<uint8_t>(m_numberOfPackets);
+    writeUInt16(m_parity.data() + 4, m_lengthRecovery);
+    writeUInt16(m_parity.data() + 6, 0);
+    delegate(m_parity.data(), HEADER_SIZE + m_parityLength);
+
+    memset(m_parity.data() + HEADER_SIZE, 0, m_parityLength);
+    m_parityLength = 0;
+    m_numberOfPackets = 0;
+    m_lengthRecovery = 0;
+}
+
+RTPFECDecoder::RTPFECDecoder(std::size_t maximumPacketSize, uint32_t window) noexcept
+    : m_maximumPacketSize{maximumPacketSize}
+    // The window must span at least one group.
+    , m_window{std::max(window, static_cast<uint32_t>(RTPFECEncoder::MAXIMUM_GROUP_SIZE) + 1)}
+    , m_slots(m_window)
+    , m_packets(m_window * maximumPacketSize)
+    , m_restored(maximumPacketSize) {
+    m_pendingParityPackets.reserve(MAXIMUM_PENDING_PARITY_PACKETS);
+}
+
+uint64_t RTPFECDecoder::restoredPackets() const noexcept {
+    return m_restoredPackets;
+}
+
+void RTPFECDecoder::addPacket(const uint8_t *packet, std::size_t length, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    if ( (RTPPacketizer::RTP_HEADER_SIZE > length) || (m_maximumPacketSize < length) ) {
+        return;
+    }
+    store(packet, length);
+    tryRestorePending(delegate);
+}
+
+void RTPFECDecoder::addParityPacket(const uint8_t *packet, std::size_t length, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    if ( (RTPFECEncoder::HEADER_SIZE >= length) || (RTPFECEncoder::VERSION != packet[0]) || (0 == packet[1])
+      || (m_maximumPacketSize < length - RTPFECEncoder::HEADER_SIZE) ) {
+        return;
+    }
+    std::vector<uint8_t> parity(packet, packet + length);
+    if (!tryRestore(parity, delegate)) {
+        if (MAXIMUM_PENDING_PARITY_PACKETS == m_pendingParityPackets.size()) {
+            m_pendingParityPackets.erase(m_pendingParityPackets.begin());
+        }
+        m_pendingParityPackets.push_back(std::move(parity));
+    }
+}
+
+void RTPFECDecoder::store(const uint8_t *packet, std::size_t length) noexcept {
+    const uint16_t SEQUENCE_NUMBER{readUInt16(packet + 2)};
+    Slot &slot = m_slots[SEQUENCE_NUMBER % m_window];
+    slot.m_valid = true;
+    slot.m_sequenceNumber = SEQUENCE_NUMBER;
+    slot.m_length = length;
+    memcpy(m_packets.data() + (SEQUENCE_NUMBER % m_window) * m_maximumPacketSize, packet, length);
+    if (0 < static_cast<int16_t>(SEQUENCE_NUMBER - m_latestSequenceNumber)) {
+        m_latestSequenceNumber = SEQUENCE_NUMBER;
+    }
+}
+
+bool RTPFECDecoder::tryRestore(const std::vector<uint8_t> &parity, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    const uint8_t NUMBER_OF_PACKETS{parity[1]};
+    const uint16_t FIRST{readUInt16(parity.data() + 2)};
+    const uint16_t LAST{static_cast<uint16_t>(FIRST + NUMBER_OF_PACKETS - 1)};
+    if (static_cast<int32_t>(m_window) <= static_cast<int16_t>(m_latestSequenceNumber - LAST)) {
+        // The group's packets are not retained anymore.
+        return true;
+    }
+
+    int32_t missing{-1};
+    for (uint8_t i{0}; i < NUMBER_OF_PACKETS; i++) {
+        const uint16_t SEQUENCE_NUMBER{static_cast<uint16_t>(FIRST + i)};
+        const Slot &slot = m_slots[SEQUENCE_NUMBER % m_window];
+        if (!slot.m_valid || (SEQUENCE_NUMBER != slot.m_sequenceNumber)) {
+            if (-1 != missing) {
+                // Two or more packets are missing; more may arrive later.
+                return false;
+            }
+            missing = i;
+        }
+    }
+    if (-1 == missing) {
+        return true;
+    }
+
+    const std::size_t PAYLOAD_LENGTH{parity.size() - RTPFECEncoder::HEADER_SIZE};
+    memcpy(m_restored.data(), parity.data() + RTPFECEncoder::HEADER_SIZE, PAYLOAD_LENGTH);
+    std::size_t length{readUInt16(parity.data() + 4)};
+    for (uint8_t i{0}; i < NUMBER_OF_PACKETS; i++) {
+        if (missing != i) {
+            const uint16_t SEQUENCE_NUMBER{static_cast<uint16_t>(FIRST + i)};
+            const Slot &slot = m_slots[SEQUENCE_NUMBER % m_window];
+            xorInto(m_restored.data(), m_packets.data() + (SEQUENCE_NUMBER % m_window) * m_maximumPacketSize, std::min(slot.m_length, PAYLOAD_LENGTH));
+            length ^= slot.m_length;
+        }
+    }
+    if ( (RTPPacketizer::RTP_HEADER_SIZE <= length) && (PAYLOAD_LENGTH >= length) ) {
+        store(m_restored.data(), length);
+        m_restoredPackets++;
+        delegate(m_restored.data(), length);
+    }
+    return true;
+}
+
+void RTPFECDecoder::tryRestorePending(const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    for (auto it = m_pendingParityPackets.begin(); it != m_pendingParityPackets.end();) {
+        if (tryRestore(*it, delegate)) {
+            it = m_pendingParityPackets.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+}
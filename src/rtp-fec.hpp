@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RTP_FEC_HPP
+#define RTP_FEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * XOR forward error correction for RTP streams. The packets of every access
+ * unit are protected in groups of consecutive packets; for every group, one
+ * parity packet holds the XOR of all its packets (including their RTP
+ * headers, zero-padded to the longest one) so that any single lost packet of
+ * a group can be restored without retransmission. Parity packets are sent as
+ * separate datagrams (usually to the RTP port + 2) with the following layout
+ * (network byte order):
+ *
+ *   version (1 byte, 1) | number of packets (1 byte) | sequence number of the first packet (2 bytes) |
+ *   XOR of the packet lengths (2 bytes) | reserved (2 bytes) | SSRC (4 bytes) | XOR of the packets
+ */
+/**
+ * This class creates parity packets for RTP packets.
+ */
+class RTPFECEncoder {
+   private:
+    RTPFECEncoder(const RTPFECEncoder &) = delete;
+    RTPFECEncoder(RTPFECEncoder &&)      = delete;
+    RTPFECEncoder &operator=(const RTPFECEncoder &) = delete;
+    RTPFECEncoder &operator=(RTPFECEncoder &&) = delete;
+
+   public:
+    enum {
+        VERSION = 1,
+        HEADER_SIZE = 12,
+        MAXIMUM_GROUP_SIZE = 255,
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param groupSize Number of RTP packets protected by one parity packet.
+     * @param maximumPacketSize Maximum size of an RTP packet.
+     */
+    RTPFECEncoder(uint32_t groupSize, std::size_t maximumPacketSize) noexcept;
+
+   public:
+    /**
+     * This method adds an RTP packet to the current group; the parity packet
+     * is passed to the delegate when the group is complete.
+     *
+     * @param packet RTP packet.
+     * @param length Length of the RTP packet.
+     * @param delegate Function to call with a parity packet; the packet is valid during the call only.
+     */
+    void add(const uint8_t *packet, std::size_t length, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+
+    /**
+     * This method completes the current group, e.g., at the end of an access
+     * unit so that its packets can be restored without waiting for the next one.
+     *
+     * @param delegate Function to call with a parity packet; the packet is valid during the call only.
+     */
+    void finish(const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+
+   private:
+    const uint32_t m_groupSize;
+    const std::size_t m_maximumPacketSize;
+    std::vector<uint8_t> m_parity;
+    std::size_t m_parityLength{0};
+    uint32_t m_numberOfPackets{0};
+    uint16_t m_lengthRecovery{0};
+};
+
+/**
+ * This class restores lost RTP packets from received RTP and parity packets;
+ * it is meant for receivers of the stream.
+ */
+class RTPFECDecoder {
+   private:
+    RTPFECDecoder(const RTPFECDecoder &) = delete;
+    RTPFECDecoder(RTPFECDecoder &&)      = delete;
+    RTPFECDecoder &operator=(const RTPFECDecoder &) = delete;
+    RTPFECDecoder &operator=(RTPFECDecoder &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param maximumPacketSize Maximum size of an RTP packet.
+     * @param window Number of the most recent RTP packets retained to restore lost ones.
+     */
+    RTPFECDecoder(std::size_t maximumPacketSize, uint32_t window = 1024) noexcept;
+
+   public:
+    /**
+     * This method adds a received RTP packet.
+     *
+     * @param packet RTP packet.
+     * @param length Length of the RTP packet.
+     * @param delegate Function to call with every restored RTP packet; the packet is valid during the call only.
+     */
+    void addPacket(const uint8_t *packet, std::size_t length, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+
+    /**
+     * This method adds a received parity packet; it is retained until its
+     * group can be restored or is outdated.
+     *
+     * @param packet Parity packet.
+     * @param length Length of the parity packet.
+     * @param delegate Function to call with every restored RTP packet; the packet is valid during the call only.
+     */
+    void addParityPacket(const uint8_t *packet, std::size_t length, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+
+    /**
+     * @return Number of restored RTP packets.
+     */
+    uint64_t restoredPackets() const noexcept;
+
+   private:
+    class Slot {
+       public:
+        bool m_valid{false};
+        uint16_t m_sequenceNumber{0};
+        std::size_t m_length{0};
+    };
+
+    void store(const uint8_t *packet, std::size_t length) noexcept;
+    bool tryRestore(const std::vector<uint8_t> &parity, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+    void tryRestorePending(const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+
+   private:
+    const std::size_t m_maximumPacketSize;
+    const uint32_t m_window;
+    std::vector<Slot> m_slots;
+    std::vector<uint8_t> m_packets;
+    std::vector<std::vector<uint8_t>> m_pendingParityPackets{};
+    std::vector<uint8_t> m_restored;
+    uint16_t m_latestSequenceNumber{0};
+    uint64_t m_restoredPackets{0};
+};
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rtp-packetizer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+constexpr uint8_t STAP_A{24};
+constexpr uint8_t FU_A{28};
+
+std::string toBase64(const std::string &data) noexcept {
+    const char *ALPHABET{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+    std::string encoded;
+    std::size_t i{0};
+    for (; i + 2 < data.size(); i += 3) {
+        const uint32_t v{(static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(data[i + 1])) << 8) | static_cast<uint8_t>(data[i + 2])};
+        encoded.push_back(ALPHABET[(v >> 18) & 0x3F]);
+        encoded.push_back(ALPHABET[(v >> 12) & 0x3F]);
+        encoded.push_back(ALPHABET[(v >> 6) & 0x3F]);
+        encoded.push_back(ALPHABET[v & 0x3F]);
+    }
+    if (i < data.size()) {
+        const bool TWO_BYTES{i + 1 < data.size()};
+        const uint32_t v{(static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << 16) | (TWO_BYTES ? (static_cast<uint32_t>(static_cast<uint8_t>(data[i + 1])) << 8) : 0)};
+        encoded.push_back(ALPHABET[(v >> 18) & 0x3F]);
+        encoded.push_back(ALPHABET[(v >> 12) & 0x3F]);
+        encoded.push_back(TWO_BYTES ? ALPHABET[(v >> 6) & 0x3F] : '=');
+        encoded.push_back('=');
+    }
+    return encoded;
+}
+}
+
+RTPPacketizer::RTPPacketizer(std::size_t mtu, uint8_t payloadType, uint8_t packetizationMode, uint32_t ssrc) noexcept
+    : m_mtu{std::max<std::size_t>(mtu, RTP_HEADER_SIZE + 3)}
+    , m_payloadType{static_cast<uint8_t>(payloadType & 0x7F)}
+    , m_packetizationMode{packetizationMode}
+    , m_ssrc{ssrc}
+    , m_sequenceNumber{static_cast<uint16_t>(ssrc ^ (ssrc >> 16))}
+    , m_packet(m_mtu, 0) {
+}
+
+uint32_t RTPPacketizer::packetize(const NalUnit *nalUnits, std::size_t numberOfNalUnits, uint32_t timeStamp, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    const std::size_t MAX_PAYLOAD{m_mtu - RTP_HEADER_SIZE};
+    uint32_t dropped{0};
+
+    for (std::size_t i{0}; i < numberOfNalUnits; i++) {
+        const NalUnit &nalUnit = nalUnits[i];
+        if (NalUnit::SPS == nalUnit.type()) {
+            if ( (m_sps.size() != nalUnit.m_length) || (0 != std::memcmp(m_sps.data(), nalUnit.m_data, nalUnit.m_length)) ) {
+                m_sps.assign(reinterpret_cast<const char*>(nalUnit.m_data), nalUnit.m_length);
+                m_parameterSetsVersion++;
+            }
+        }
+        else if (NalUnit::PPS == nalUnit.type()) {
+            if ( (m_pps.size() != nalUnit.m_length) || (0 != std::memcmp(m_pps.data(), nalUnit.m_data, nalUnit.m_length)) ) {
+                m_pps.assign(reinterpret_cast<const char*>(nalUnit.m_data), nalUnit.m_length);
+                m_parameterSetsVersion++;
+            }
+        }
+    }
+
+    std::size_t i{0};
+    while (i < numberOfNalUnits) {
+        const NalUnit &nalUnit = nalUnits[i];
+        if (0 == nalUnit.m_length) {
+            i++;
+        }
+        else if (MAX_PAYLOAD >= nalUnit.m_length) {
+            std::size_t last{i};
+            if (1 == m_packetizationMode) {
+                // Aggregate following NAL units as long as the STAP-A fits into one packet.
+                std::size_t size{1 + 2 + nalUnit.m_length};
+                while ( (last + 1 < numberOfNalUnits) && (0 < nalUnits[last + 1].m_length) && (MAX_PAYLOAD >= size + 2 + nalUnits[last + 1].m_length) ) {
+                    size += 2 + nalUnits[last + 1].m_length;
+                    last++;
+                }
+            }
+            emit(nalUnits, i, last, (last + 1 == numberOfNalUnits), timeStamp, delegate);
+            i = last + 1;
+        }
+        else if (1 == m_packetizationMode) {
+            fragment(nalUnit, (i + 1 == numberOfNalUnits), timeStamp, delegate);
+            i++;
+        }
+        else {
+            dropped++;
+            i++;
+        }
+    }
+    return dropped;
+}
+
+void RTPPacketizer::emit(const NalUnit *nalUnits, std::size_t first, std::size_t last, bool marker, uint32_t timeStamp, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    writeHeader(marker, timeStamp);
+    uint8_t *payload = m_packet.data() + RTP_HEADER_SIZE;
+    std::size_t length{RTP_HEADER_SIZE};
+    if (first == last) {
+        std::memcpy(payload, nalUnits[first].m_data, nalUnits[first].m_length);
+        length += nalUnits[first].m_length;
+    }
+    else {
+        uint8_t forbiddenBit{0};
+        uint8_t nri{0};
+        length += 1;
+        for (std::size_t i{first}; i <= last; i++) {
+            forbiddenBit |= nalUnits[i].m_data[0] & 0x80;
+            nri = std::max<uint8_t>(nri, nalUnits[i].m_data[0] & 0x60);
+            m_packet[length++] = static_cast<uint8_t>(nalUnits[i].m_length >> 8);
+            m_packet[length++] = static_cast<uint8_t>(nalUnits[i].m_length & 0xFF);
+            std::memcpy(m_packet.data() + length, nalUnits[i].m_data, nalUnits[i].m_length);
+            length += nalUnits[i].m_length;
+        }
+        payload[0] = static_cast<uint8_t>(forbiddenBit | nri | STAP_A);
+    }
+    delegate(m_packet.data(), length);
+}
+
+void RTPPacketizer::fragment(const NalUnit &nalUnit, bool marker, uint32_t timeStamp, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept {
+    const std::size_t MAX_FRAGMENT{m_mtu - RTP_HEADER_SIZE - 2};
+    const uint8_t INDICATOR{static_cast<uint8_t>((nalUnit.m_data[0] & 0xE0) | FU_A)};
+    const uint8_t TYPE{static_cast<uint8_t>(nalUnit.m_data[0] & 0x1F)};
+
+    // The NAL unit header is conveyed in FU indicator and FU header.
+    const uint8_t *data = nalUnit.m_data + 1;
+    std::size_t remaining{nalUnit.m_length - 1};
+    bool start{true};
+    while (0 < remaining) {
+        const std::size_t LENGTH{std::min(remaining, MAX_FRAGMENT)};
+        const bool END{LENGTH == remaining};
+        writeHeader(marker && END, timeStamp);
+        m_packet[RTP_HEADER_SIZE] = INDICATOR;
+        m_packet[RTP_HEADER_SIZE + 1] = static_cast<uint8_t>((start ? 0x80 : 0x00) | (END ? 0x40 : 0x00) | TYPE);
+        std::memcpy(m_packet.data() + RTP_HEADER_SIZE + 2, data, LENGTH);
+        delegate(m_packet.data(), RTP_HEADER_SIZE + 2 + LENGTH);
+        data += LENGTH;
+        remaining -= LENGTH;
+        start = false;
+    }
+}
+
+void RTPPacketizer::writeHeader(bool marker, uint32_t timeStamp) noexcept {
+    m_packet[0] = 0x80; // Version 2, no padding, no extension, no CSRC.
+    m_packet[1] = static_cast<uint8_t>((marker ? 0x80 : 0x00) | m_payloadType);
+    m_packet[2] = static_cast<uint8_t>(m_sequenceNumber >> 8);
+    m_packet[3] = static_cast<uint8_t>(m_sequenceNumber & 0xFF);
+    m_packet[4] = static_cast<uint8_t>(timeStamp >> 24);
+    m_packet[5] = static_cast<uint8_t>((timeStamp >> 16) & 0xFF);
+    m_packet[6] = static_cast<uint8_t>((timeStamp >> 8) & 0xFF);
+    m_packet[7] = static_cast<uint8_t>(timeStamp & 0xFF);
+    m_packet[8] = static_cast<uint8_t>(m_ssrc >> 24);
+    m_packet[9] = static_cast<uint8_t>((m_ssrc >> 16) & 0xFF);
+    m_packet[10] = static_cast<uint8_t>((m_ssrc >> 8) & 0xFF);
+    m_packet[11] = static_cast<uint8_t>(m_ssrc & 0xFF);
+    m_sequenceNumber++;
+}
+
+const std::string &RTPPacketizer::sps() const noexcept {
+    return m_sps;
+}
+
+const std::string &RTPPacketizer::pps() const noexcept {
+    return m_pps;
+}
+
+uint32_t RTPPacketizer::parameterSetsVersion() const noexcept {
+    return m_parameterSetsVersion;
+}
+
+std::string RTPPacketizer::sdp(const std::string &address, uint16_t port) const noexcept {
+    const bool MULTICAST{(224 <= std::atoi(address.c_str())) && (239 >= std::atoi(address.c_str()))};
+    std::stringstream sstr;
+    sstr << "v=0\r\n"
+         << "o=- " << m_ssrc << " 0 IN IP4 " << address << "\r\n"
+         << "s=opendlv-video-h264-encoder\r\n"
+         << "c=IN IP4 " << address << (MULTICAST ? "/16" : "") << "\r\n"
+         << "t=0 0\r\n"
+         << "m=video " << port << " RTP/AVP " << static_cast<uint32_t>(m_payloadType) << "\r\n"
+         << "a=rtpmap:" << static_cast<uint32_t>(m_payloadType) << " H264/" << static_cast<uint32_t>(CLOCK_RATE) << "\r\n"
+         << "a=fmtp:" << static_cast<uint32_t>(m_payloadType) << " packetization-mode=" << static_cast<uint32_t>(m_packetizationMode);
+    if (4 <= m_sps.size()) {
+        // profile_idc, constraint flags, and level_idc follow the NAL unit header.
+        sstr << ";profile-level-id=" << std::hex << std::setfill('0');
+        for (std::size_t i{1}; i < 4; i++) {
+            sstr << std::setw(2) << static_cast<uint32_t>(static_cast<uint8_t>(m_sps[i]));
+        }
+        sstr << std::dec;
+    }
+    if (!m_sps.empty() && !m_pps.empty()) {
+        sstr << ";sprop-parameter-sets=" << toBase64(m_sps) << "," << toBase64(m_pps);
+    }
+    sstr << "\r\n";
+    return sstr.str();
+}
+
+uint32_t RTPPacketizer::toRTPTimeStamp(int64_t microseconds) noexcept {
+    // Split into seconds and remainder to not overflow for epoch-based time points.
+    const uint64_t US{static_cast<uint64_t>(microseconds)};
+    return static_cast<uint32_t>((US / 1000000) * CLOCK_RATE + ((US % 1000000) * CLOCK_RATE) / 1000000);
+}
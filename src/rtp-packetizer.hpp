@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RTP_PACKETIZER_HPP
+#define RTP_PACKETIZER_HPP
+
+#include "nal-unit.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * This class packetizes h264 access units into RTP packets according to
+ * RFC 6184. In packetization mode 0, every NAL unit is sent in its own packet
+ * (the encoder must limit slices to the MTU). In packetization mode 1
+ * (non-interleaved), consecutive small NAL units are aggregated into STAP-A
+ * packets and NAL units exceeding the MTU are fragmented into FU-A packets.
+ */
+class RTPPacketizer {
+   private:
+    RTPPacketizer(const RTPPacketizer &) = delete;
+    RTPPacketizer(RTPPacketizer &&)      = delete;
+    RTPPacketizer &operator=(const RTPPacketizer &) = delete;
+    RTPPacketizer &operator=(RTPPacketizer &&) = delete;
+
+   public:
+    enum {
+        RTP_HEADER_SIZE = 12,
+        CLOCK_RATE = 90000,
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param mtu Maximum size of an RTP packet (without IP and UDP headers).
+     * @param payloadType Dynamic RTP payload type.
+     * @param packetizationMode 0: single NAL unit mode; 1: non-interleaved mode.
+     * @param ssrc Synchronization source identifier.
+     */
+    RTPPacketizer(std::size_t mtu, uint8_t payloadType, uint8_t packetizationMode, uint32_t ssrc) noexcept;
+
+   public:
+    /**
+     * This method packetizes one access unit; the marker bit is set on its last packet.
+     *
+     * @param nalUnits NAL units of the access unit.
+     * @param numberOfNalUnits Number of NAL units.
+     * @param timeStamp 90 kHz RTP time stamp.
+     * @param delegate Function to call for every packet; the packet is valid during the call only.
+     * @return Number of NAL units that had to be dropped as they exceed the MTU in mode 0.
+     */
+    uint32_t packetize(const NalUnit *nalUnits, std::size_t numberOfNalUnits, uint32_t timeStamp, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+
+    /**
+     * @return Latest sequence parameter set seen (without start code).
+     */
+    const std::string &sps() const noexcept;
+
+    /**
+     * @return Latest picture parameter set seen (without start code).
+     */
+    const std::string &pps() const noexcept;
+
+    /**
+     * @return Counter that is incremented whenever the SPS or the PPS change.
+     */
+    uint32_t parameterSetsVersion() const noexcept;
+
+    /**
+     * This method creates an SDP description for a stream sent by this packetizer.
+     *
+     * @param address Destination address.
+     * @param port Destination port.
+     * @return SDP description.
+     */
+    std::string sdp(const std::string &address, uint16_t port) const noexcept;
+
+    /**
+     * @param microseconds Time point in microseconds.
+     * @return Corresponding 90 kHz RTP time stamp.
+     */
+    static uint32_t toRTPTimeStamp(int64_t microseconds) noexcept;
+
+   private:
+    void emit(const NalUnit *nalUnits, std::size_t first, std::size_t last, bool marker, uint32_t timeStamp, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+    void fragment(const NalUnit &nalUnit, bool marker, uint32_t timeStamp, const std::function<void(const uint8_t *packet, std::size_t length)> &delegate) noexcept;
+    void writeHeader(bool marker, uint32_t timeStamp) noexcept;
+
+   private:
+    const std::size_t m_mtu;
+    const uint8_t m_payloadType;
+    const uint8_t m_packetizationMode;
+    const uint32_t m_ssrc;
+    uint16_t m_sequenceNumber;
+    std::vector<uint8_t> m_packet;
+    std::string m_sps{};
+    std::string m_pps{};
+    uint32_t m_parameterSetsVersion{0};
+};
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared-memory-sink.hpp"
+
+#include <cstring>
+#include <new>
+
+namespace {
+uint32_t alignedSlotSize(uint32_t slotSize) noexcept {
+    // Keep every H264RingSlot 8-byte aligned for its atomic sequenceNumber.
+    return (slotSize + 7u) & ~7u;
+}
+}
+
+SharedMemorySink::SharedMemorySink(const std::string &name, uint32_t numberOfSlots, uint32_t slotSize, uint32_t width, uint32_t height) noexcept
+    : m_numberOfSlots{numberOfSlots}
+    , m_slotSize{alignedSlotSize(slotSize)} {
+    const uint64_t SIZE{sizeof(H264RingHeader) + static_cast<uint64_t>(m_numberOfSlots) * (sizeof(H264RingSlot) + m_slotSize)};
+    if ( (0 < m_numberOfSlots) && (0xFFFFFFFFu >= SIZE) ) {
+        m_sharedMemory.reset(new cluon::SharedMemory{name, static_cast<uint32_t>(SIZE)});
+    }
+    if (m_sharedMemory && m_sharedMemory->valid()) {
+        m_sharedMemory->lock();
+        {
+            m_header = new (m_sharedMemory->data()) H264RingHeader;
+            m_header->magic = H264RingHeader::MAGIC;
+            m_header->version = H264RingHeader::VERSION;
+            m_header->numberOfSlots = m_numberOfSlots;
+            m_header->slotSize = m_slotSize;
+            m_header->width = width;
+            m_header->height = height;
+            m_header->sequenceNumber.store(0);
+            for (uint32_t i{0}; i < m_numberOfSlots; i++) {
+                H264RingSlot *s = new (m_sharedMemory->data() + sizeof(H264RingHeader) + i * (sizeof(H264RingSlot) + m_slotSize)) H264RingSlot;
+                s->sequenceNumber.store(0);
+                s->sampleTimeStamp = 0;
+                s->size = 0;
+                s->frameType = 0;
+            }
+        }
+        m_sharedMemory->unlock();
+    }
+}
+
+bool SharedMemorySink::valid() noexcept {
+    return (nullptr != m_header) && m_sharedMemory->valid();
+}
+
+const std::string SharedMemorySink::name() const noexcept {
+    return (m_sharedMemory ? m_sharedMemory->name() : std::string());
+}
+
+bool SharedMemorySink::write(const uint8_t *data, uint32_t length, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t frameType) noexcept {
+    if ( !valid() || (m_slotSize < length) ) {
+        return false;
+    }
+
+    const uint64_t SEQUENCE_NUMBER{++m_sequenceNumber};
+    H264RingSlot *s = slot(SEQUENCE_NUMBER);
+
+    m_sharedMemory->lock();
+    {
+        s->sequenceNumber.store(0, std::memory_order_relaxed);
+        // Keeps the payload from becoming visible before the slot is marked as being written.
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(reinterpret_cast<uint8_t*>(s) + sizeof(H264RingSlot), data, length);
+        s->sampleTimeStamp = cluon::time::toMicroseconds(sampleTimeStamp);
+        s->size = length;
+        s->frameType = frameType;
+        s->sequenceNumber.store(SEQUENCE_NUMBER, std::memory_order_release);
+        m_header->sequenceNumber.store(SEQUENCE_NUMBER, std::memory_order_release);
+        m_sharedMemory->setTimeStamp(sampleTimeStamp);
+    }
+    m_sharedMemory->unlock();
+    m_sharedMemory->notifyAll();
+    return true;
+}
+
+H264RingSlot *SharedMemorySink::slot(uint64_t sequenceNumber) noexcept {
+    const uint64_t INDEX{(sequenceNumber - 1) % m_numberOfSlots};
+    return reinterpret_cast<H264RingSlot*>(m_sharedMemory->data() + sizeof(H264RingHeader) + INDEX * (sizeof(H264RingSlot) + m_slotSize));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARED_MEMORY_SINK_HPP
+#define SHARED_MEMORY_SINK_HPP
+
+#include "cluon-complete.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Layout of the shared memory area written by SharedMemorySink:
+ *
+ *   H264RingHeader | H264RingSlot 0 | payload 0 | H264RingSlot 1 | payload 1 | ...
+ *
+ * Every H264RingSlot is followed by slotSize bytes for one Annex-B access
+ * unit; slot i starts at sizeof(H264RingHeader) + i * (sizeof(H264RingSlot) + slotSize).
+ * Frame n (starting at 1) is written to slot (n - 1) % numberOfSlots.
+ *
+ * A slot's sequenceNumber is 0 while the slot is being written and is set to
+ * the frame's sequence number afterwards. Consumers can therefore work on the
+ * payload in place without taking the lock if they follow the seqlock protocol:
+ *
+ *   1. load sequenceNumber with std::memory_order_acquire (skip if 0),
+ *   2. copy or process the slot's fields and payload,
+ *   3. issue std::atomic_thread_fence(std::memory_order_acquire),
+ *   4. load sequenceNumber again (relaxed) and discard the result if it changed.
+ *
+ * Consumers are woken up by notifyAll() after each frame.
+ */
+struct H264RingHeader {
+    static constexpr uint32_t MAGIC{0x34363248}; // "H264"
+    static constexpr uint32_t VERSION{1};
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numberOfSlots;
+    uint32_t slotSize;
+    uint32_t width;
+    uint32_t height;
+    std::atomic<uint64_t> sequenceNumber; // Latest completely written frame; 0: none.
+};
+
+struct H264RingSlot {
+    std::atomic<uint64_t> sequenceNumber;
+    int64_t sampleTimeStamp; // Microseconds since epoch.
+    uint32_t size;           // Bytes used in the payload.
+    uint32_t frameType;      // openh264's EVideoFrameType (1: IDR, 2: I, 3: P).
+};
+
+/**
+ * This class publishes encoded h264 frames into a ring of slots residing in
+ * a named shared memory area, allowing consumers on the same host to read
+ * them without going through the network stack.
+ */
+class SharedMemorySink {
+   private:
+    SharedMemorySink(const SharedMemorySink &) = delete;
+    SharedMemorySink(SharedMemorySink &&)      = delete;
+    SharedMemorySink &operator=(const SharedMemorySink &) = delete;
+    SharedMemorySink &operator=(SharedMemorySink &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param name Name of the shared memory area to create.
+     * @param numberOfSlots Number of frames to keep.
+     * @param slotSize Maximum size of one access unit.
+     * @param width Width of the encoded frames.
+     * @param height Height of the encoded frames.
+     */
+    SharedMemorySink(const std::string &name, uint32_t numberOfSlots, uint32_t slotSize, uint32_t width, uint32_t height) noexcept;
+
+   public:
+    /**
+     * @return true if the shared memory area could be created.
+     */
+    bool valid() noexcept;
+
+    /**
+     * @return Name of the shared memory area.
+     */
+    const std::string name() const noexcept;
+
+    /**
+     * This method writes an access unit into the next slot and notifies all consumers.
+     *
+     * @param data Access unit.
+     * @param length Length of the access unit.
+     * @param sampleTimeStamp Time point when the frame was captured.
+     * @param frameType openh264's frame type.
+     * @return true if the access unit was written; false if it does not fit into a slot.
+     */
+    bool write(const uint8_t *data, uint32_t length, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t frameType) noexcept;
+
+   private:
+    H264RingSlot *slot(uint64_t sequenceNumber) noexcept;
+
+   private:
+    std::unique_ptr<cluon::SharedMemory> m_sharedMemory{nullptr};
+    H264RingHeader *m_header{nullptr};
+    uint32_t m_numberOfSlots{0};
+    uint32_t m_slotSize{0};
+    uint64_t m_sequenceNumber{0};
+};
+
+#endif
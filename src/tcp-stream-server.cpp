@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tcp-stream-server.hpp"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+constexpr int32_t TCPStreamServer::SEND_TIMEOUT_MS;
+constexpr int32_t TCPStreamServer::ACCEPT_TIMEOUT_MS;
+
+namespace {
+std::string toString(const struct sockaddr_storage &address, socklen_t length) noexcept {
+    char host[NI_MAXHOST]{};
+    char service[NI_MAXSERV]{};
+    if (0 != ::getnameinfo(reinterpret_cast<const struct sockaddr*>(&address), length, host, sizeof(host), service, sizeof(service), NI_NUMERICHOST | NI_NUMERICSERV)) {
+        return "unknown client";
+    }
+    return std::string(host) + ":" + service;
+}
+}
+
+TCPStreamServer::TCPStreamServer(uint16_t port, uint32_t maximumQueuedFrames, std::size_t maximumFrameSize) noexcept
+    : m_maximumQueuedFrames{std::max(maximumQueuedFrames, 1u)}
+    , m_maximumFrameSize{maximumFrameSize} {
+    // Accept IPv4 clients on an IPv6 socket if available.
+    struct sockaddr_in6 address6;
+    std::memset(&address6, 0, sizeof(address6));
+    address6.sin6_family = AF_INET6;
+    address6.sin6_port = htons(port);
+    address6.sin6_addr = in6addr_any;
+    struct sockaddr_in address4;
+    std::memset(&address4, 0, sizeof(address4));
+    address4.sin_family = AF_INET;
+    address4.sin_port = htons(port);
+    address4.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    const struct sockaddr *address{reinterpret_cast<const struct sockaddr*>(&address6)};
+    socklen_t addressLength{sizeof(address6)};
+    m_socket = ::socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (0 > m_socket) {
+        address = reinterpret_cast<const struct sockaddr*>(&address4);
+        addressLength = sizeof(address4);
+        m_socket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    else {
+        int32_t v6Only{0};
+        ::setsockopt(m_socket, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only));
+    }
+    if (0 > m_socket) {
+        std::cerr << "[TCPStreamServer]: Failed to create socket: " << strerror(errno) << std::endl;
+        m_socket = -1;
+        return;
+    }
+    int32_t reuseAddress{1};
+    ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+    if ( (0 != ::bind(m_socket, address, addressLength)) || (0 != ::listen(m_socket, SOMAXCONN)) ) {
+        std::cerr << "[TCPStreamServer]: Failed to listen on port " << port << ": " << strerror(errno) << std::endl;
+        ::close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    m_running.store(true);
+    try {
+        m_acceptThread = std::thread(&TCPStreamServer::acceptClients, this);
+    } catch (...) {
+        m_running.store(false);
+    }
+}
+
+TCPStreamServer::~TCPStreamServer() noexcept {
+    // Stop accepting before releasing the clients.
+    m_running.store(false);
+    if (m_acceptThread.joinable()) {
+        m_acceptThread.join();
+    }
+    if (-1 != m_socket) {
+        ::close(m_socket);
+    }
+
+    std::vector<std::shared_ptr<Client>> clients;
+    {
+        std::lock_guard<std::mutex> lck(m_clientsMutex);
+        clients.swap(m_clients);
+    }
+    for (auto &client : clients) {
+        std::lock_guard<std::mutex> clientLock(client->m_mutex);
+        client->m_running = false;
+        client->m_condition.notify_all();
+    }
+    // A sender thread waiting for an unresponsive client returns after SEND_TIMEOUT_MS.
+    for (auto &client : clients) {
+        if (client->m_thread.joinable()) {
+            client->m_thread.join();
+        }
+    }
+}
+
+bool TCPStreamServer::isRunning() const noexcept {
+    return m_running.load();
+}
+
+void TCPStreamServer::acceptClients() noexcept {
+    while (m_running.load()) {
+        struct pollfd listening{m_socket, POLLIN, 0};
+        if (0 >= ::poll(&listening, 1, ACCEPT_TIMEOUT_MS)) {
+            continue;
+        }
+        struct sockaddr_storage address;
+        socklen_t length{sizeof(address)};
+        const int32_t SOCKET{::accept4(m_socket, reinterpret_cast<struct sockaddr*>(&address), &length, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+        if (-1 != SOCKET) {
+            accept(SOCKET, toString(address, length));
+        }
+    }
+}
+
+void TCPStreamServer::accept(int32_t socket, std::string &&from) noexcept {
+    std::shared_ptr<Client> client{std::make_shared<Client>()};
+    client->m_address = from;
+    client->m_socket = socket;
+    client->m_queue.resize(m_maximumQueuedFrames + 1, nullptr);
+
+    try {
+        client->m_thread = std::thread(&TCPStreamServer::sendFrames, this, client.get());
+    } catch (...) {
+        std::cerr << "[TCPStreamServer]: Failed to start sending to " << from << "." << std::endl;
+        ::close(socket);
+        return;
+    }
+    std::clog << "[TCPStreamServer]: " << from << " connected." << std::endl;
+
+    // Release disconnected clients here to keep their destruction away from the caller of publish.
+    std::vector<std::shared_ptr<Client>> disconnectedClients;
+    {
+        std::lock_guard<std::mutex> lck(m_clientsMutex);
+        for (auto it = m_clients.begin(); it != m_clients.end();) {
+            bool running{false};
+            {
+                std::lock_guard<std::mutex> clientLock((*it)->m_mutex);
+                running = (*it)->m_running;
+            }
+            if (running) {
+                it++;
+            }
+            else {
+                disconnectedClients.push_back(*it);
+                it = m_clients.erase(it);
+            }
+        }
+        m_clients.push_back(client);
+    }
+    for (auto &disconnectedClient : disconnectedClients) {
+        if (disconnectedClient->m_thread.joinable()) {
+            disconnectedClient->m_thread.join();
+        }
+    }
+}
+
+void TCPStreamServer::publish(const uint8_t *data, std::size_t length, bool isIDR, const KeyFrameCache *cache) noexcept {
+    std::lock_guard<std::mutex> lck(m_clientsMutex);
+    if (m_clients.empty()) {
+        return;
+    }
+
+    Frame *frame{acquireFrame(reinterpret_cast<const char*>(data), length)};
+    for (auto &client : m_clients) {
+        std::lock_guard<std::mutex> clientLock(client->m_mutex);
+        if (!client->m_running) {
+            continue;
+        }
+        if (client->m_new) {
+            client->m_new = false;
+            if (!isIDR && (nullptr != cache) && cache->isComplete()) {
+                // The cache reuses its buffers; hence, a new client gets copies.
+                for (auto &f : cache->frames()) {
+                    enqueue(*client, acquireFrame(f.m_data->data(), f.m_data->size()));
+                }
+                client->m_primedFrames = cache->frames().size();
+                client->m_waitForIDR = false;
+            }
+        }
+        if (m_maximumQueuedFrames + client->m_primedFrames <= client->m_queueCount) {
+            // Frames depend on their predecessors; hence, resume with the next IDR frame.
+            clearQueue(*client);
+            client->m_primedFrames = 0;
+            client->m_waitForIDR = true;
+            m_droppedQueues++;
+        }
+        if (client->m_waitForIDR && !isIDR) {
+            continue;
+        }
+        client->m_waitForIDR = false;
+        retainFrame(frame);
+        enqueue(*client, frame);
+        client->m_condition.notify_all();
+    }
+    releaseFrame(frame);
+}
+
+void TCPStreamServer::sendFrames(Client *client) noexcept {
+    while (true) {
+        Frame *frame{nullptr};
+        {
+            std::unique_lock<std::mutex> lck(client->m_mutex);
+            if (!client->m_condition.wait_for(lck, std::chrono::milliseconds(SEND_TIMEOUT_MS), [&client]() { return (0 < client->m_queueCount) || !client->m_running; })) {
+                // Notice clients that disconnected while waiting for frames, e.g., for the next IDR frame.
+                struct pollfd connection{client->m_socket, POLLRDHUP, 0};
+                if ( (0 < ::poll(&connection, 1, 0)) && (0 != (connection.revents & (POLLRDHUP | POLLHUP | POLLERR))) ) {
+                    break;
+                }
+                continue;
+            }
+            if (!client->m_running) {
+                break;
+            }
+            frame = client->m_queue[client->m_queueHead];
+            client->m_queueHead = (client->m_queueHead + 1) % client->m_queue.size();
+            client->m_queueCount--;
+            client->m_primedFrames -= (0 < client->m_primedFrames) ? 1 : 0;
+        }
+
+        const bool SENT{sendFully(client, frame->m_data)};
+        releaseFrame(frame);
+        if (!SENT) {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(client->m_mutex);
+        client->m_running = false;
+        clearQueue(*client);
+    }
+    ::close(client->m_socket);
+    std::clog << "[TCPStreamServer]: " << client->m_address << " disconnected." << std::endl;
+}
+
+bool TCPStreamServer::sendFully(Client *client, const std::string &data) noexcept {
+    for (std::size_t offset{0}; offset < data.size();) {
+        // MSG_NOSIGNAL: a client closing its connection must not terminate the encoder.
+        const ssize_t SENT{::send(client->m_socket, data.data() + offset, data.size() - offset, MSG_NOSIGNAL)};
+        if (0 < SENT) {
+            offset += static_cast<std::size_t>(SENT);
+        }
+        else if ( (0 > SENT) && ( (EAGAIN == errno) || (EWOULDBLOCK == errno) ) ) {
+            struct pollfd writable{client->m_socket, POLLOUT, 0};
+            ::poll(&writable, 1, SEND_TIMEOUT_MS);
+            std::lock_guard<std::mutex> lck(client->m_mutex);
+            if (!client->m_running) {
+                return false;
+            }
+        }
+        else if ( (0 > SENT) && (EINTR == errno) ) {
+            continue;
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+TCPStreamServer::Frame *TCPStreamServer::acquireFrame(const char *data, std::size_t length) noexcept {
+    Frame *frame{nullptr};
+    {
+        std::lock_guard<std::mutex> lck(m_framesMutex);
+        if (m_freeFrames.empty()) {
+            m_frames.emplace_back(new Frame{});
+            frame = m_frames.back().get();
+            frame->m_data.reserve(m_maximumFrameSize);
+            // Releasing a frame must not allocate.
+            m_freeFrames.reserve(m_frames.size());
+        }
+        else {
+            frame = m_freeFrames.back();
+            m_freeFrames.pop_back();
+        }
+        frame->m_references = 1;
+    }
+    frame->m_data.assign(data, length);
+    return frame;
+}
+
+void TCPStreamServer::retainFrame(Frame *frame) noexcept {
+    std::lock_guard<std::mutex> lck(m_framesMutex);
+    frame->m_references++;
+}
+
+void TCPStreamServer::releaseFrame(Frame *frame) noexcept {
+    // The mutex orders the last reads of a frame before it is overwritten.
+    std::lock_guard<std::mutex> lck(m_framesMutex);
+    if (0 == --frame->m_references) {
+        m_freeFrames.push_back(frame);
+    }
+}
+
+void TCPStreamServer::clearQueue(Client &client) noexcept {
+    for (std::size_t i{0}; i < client.m_queueCount; i++) {
+        releaseFrame(client.m_queue[(client.m_queueHead + i) % client.m_queue.size()]);
+    }
+    client.m_queueHead = 0;
+    client.m_queueCount = 0;
+}
+
+void TCPStreamServer::enqueue(Client &client, Frame *frame) noexcept {
+    if (client.m_queue.size() == client.m_queueCount) {
+        // Only priming a new client with the cached frames exceeds the initial size.
+        std::vector<Frame*> queue(2 * client.m_queue.size(), nullptr);
+        for (std::size_t i{0}; i < client.m_queueCount; i++) {
+            queue[i] = client.m_queue[(client.m_queueHead + i) % client.m_queue.size()];
+        }
+        client.m_queue.swap(queue);
+        client.m_queueHead = 0;
+    }
+    client.m_queue[(client.m_queueHead + client.m_queueCount) % client.m_queue.size()] = frame;
+    client.m_queueCount++;
+}
+
+bool TCPStreamServer::waitsForIDR() const noexcept {
+    std::lock_guard<std::mutex> lck(m_clientsMutex);
+    for (auto &client : m_clients) {
+        // New clients are started with the cached frames with the next access unit, if possible.
+        std::lock_guard<std::mutex> clientLock(client->m_mutex);
+        if (client->m_running && !client->m_new && client->m_waitForIDR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t TCPStreamServer::numberOfClients() const noexcept {
+    std::lock_guard<std::mutex> lck(m_clientsMutex);
+    uint32_t count{0};
+    for (auto &client : m_clients) {
+        std::lock_guard<std::mutex> clientLock(client->m_mutex);
+        count += (client->m_running ? 1 : 0);
+    }
+    return count;
+}
+
+uint64_t TCPStreamServer::droppedQueues() const noexcept {
+    return m_droppedQueues.load();
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TCP_STREAM_SERVER_HPP
+#define TCP_STREAM_SERVER_HPP
+
+#include "key-frame-cache.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * This class streams Annex-B h264 access units to any number of TCP clients
+ * (e.g., ffplay -f h264 tcp://host:port). Every client has its own bounded
+ * queue that is drained by its own sender thread, so that a slow client
+ * neither stalls the caller nor other clients. When a client's queue is full,
+ * it is dropped completely and the client resumes with the next IDR frame.
+ * New clients start with the cached access units since the last IDR frame
+ * when available, or with the next IDR frame otherwise.
+ *
+ * Access units are queued for all clients in shared buffers that are handed
+ * back to a free list once every client has sent them. Client sockets are
+ * non-blocking; a sender thread waits for a client to accept more data for at
+ * most TCPStreamServer::SEND_TIMEOUT_MS at once before checking whether it is
+ * to stop, so that a client that stopped reading does not keep its sender
+ * thread from being joined.
+ */
+class TCPStreamServer {
+   private:
+    TCPStreamServer(const TCPStreamServer &) = delete;
+    TCPStreamServer(TCPStreamServer &&)      = delete;
+    TCPStreamServer &operator=(const TCPStreamServer &) = delete;
+    TCPStreamServer &operator=(TCPStreamServer &&) = delete;
+
+   public:
+    static constexpr int32_t SEND_TIMEOUT_MS{250};
+    static constexpr int32_t ACCEPT_TIMEOUT_MS{250};
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param port TCP port to listen on.
+     * @param maximumQueuedFrames Maximum number of access units queued per client.
+     * @param maximumFrameSize Largest expected access unit to reserve memory for.
+     */
+    TCPStreamServer(uint16_t port, uint32_t maximumQueuedFrames, std::size_t maximumFrameSize) noexcept;
+    ~TCPStreamServer() noexcept;
+
+   public:
+    /**
+     * @return true if the server is listening.
+     */
+    bool isRunning() const noexcept;
+
+    /**
+     * This method queues an access unit for all connected clients.
+     *
+     * @param data Annex-B access unit.
+     * @param length Length of the access unit.
+     * @param isIDR true if the access unit is an IDR frame.
+     * @param cache Optional access units preceding this one to start new clients with.
+     */
+    void publish(const uint8_t *data, std::size_t length, bool isIDR, const KeyFrameCache *cache = nullptr) noexcept;
+
+    /**
+     * @return true if a connected client waits for the next IDR frame.
+     */
+    bool waitsForIDR() const noexcept;
+
+    /**
+     * @return Number of connected clients.
+     */
+    uint32_t numberOfClients() const noexcept;
+
+    /**
+     * @return Number of times a client's queue was dropped as the client fell behind.
+     */
+    uint64_t droppedQueues() const noexcept;
+
+   private:
+    class Frame {
+       public:
+        std::string m_data{};
+        // Number of clients that have yet to send this frame; guarded by m_framesMutex.
+        uint32_t m_references{0};
+    };
+
+    class Client {
+       public:
+        std::string m_address{};
+        std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        // Ring buffer of queued frames; unlike a deque, it does not allocate while cycling.
+        std::vector<Frame*> m_queue{};
+        std::size_t m_queueHead{0};
+        std::size_t m_queueCount{0};
+        bool m_new{true};
+        bool m_waitForIDR{true};
+        bool m_running{true};
+        // Cached access units queued for a new client do not count towards its limit.
+        std::size_t m_primedFrames{0};
+        // Closed by the sender thread when it stops.
+        int32_t m_socket{-1};
+        std::thread m_thread{};
+    };
+
+    void acceptClients() noexcept;
+    void accept(int32_t socket, std::string &&from) noexcept;
+    void sendFrames(Client *client) noexcept;
+    bool sendFully(Client *client, const std::string &data) noexcept;
+
+    Frame *acquireFrame(const char *data, std::size_t length) noexcept;
+    void retainFrame(Frame *frame) noexcept;
+    void releaseFrame(Frame *frame) noexcept;
+    void clearQueue(Client &client) noexcept;
+    void enqueue(Client &client, Frame *frame) noexcept;
+
+   private:
+    const uint32_t m_maximumQueuedFrames;
+    const std::size_t m_maximumFrameSize;
+
+    mutable std::mutex m_clientsMutex{};
+    std::vector<std::shared_ptr<Client>> m_clients{};
+    std::atomic<uint64_t> m_droppedQueues{0};
+
+    std::mutex m_framesMutex{};
+    std::vector<std::unique_ptr<Frame>> m_frames{};
+    std::vector<Frame*> m_freeFrames{};
+
+    int32_t m_socket{-1};
+    std::atomic<bool> m_running{false};
+    std::thread m_acceptThread{};
+};
+
+#endif